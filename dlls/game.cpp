@@ -18,6 +18,7 @@
 #include "game.h"
 
 cvar_t	displaysoundlist = {"displaysoundlist","0"};
+cvar_t	displaylosstats = {"displaylosstats","0"};
 
 // multiplayer server rules
 cvar_t	fragsleft	= {"mp_fragsleft","0", FCVAR_SERVER | FCVAR_UNLOGGED };	  // Don't spam console/log files/users with this changing
@@ -461,6 +462,7 @@ void GameDLLInit( void )
 	g_footsteps = CVAR_GET_POINTER( "mp_footsteps" );
 
 	CVAR_REGISTER (&displaysoundlist);
+	CVAR_REGISTER (&displaylosstats);
 
 	CVAR_REGISTER (&teamplay);
 	CVAR_REGISTER (&fraglimit);
@@ -20,6 +20,7 @@ extern void GameDLLInit( void );
 
 
 extern cvar_t	displaysoundlist;
+extern cvar_t	displaylosstats;
 
 // multiplayer server rules
 extern cvar_t	teamplay;
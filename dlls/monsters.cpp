@@ -33,9 +33,14 @@
 #include "decals.h"
 #include "soundent.h"
 #include "gamerules.h"
+#include "game.h"
+#include "physcallback.h"
 
 #define MONSTER_CUT_CORNER_DIST		8 // 8 means the monster's bounding box is contained without the box of the node in WC
 
+#define LOS_CACHE_SIZE				1024 // must be power of two
+#define LOS_CELL_SIZE				16 // eye positions closer than this share the result
+
 
 Vector VecBModelOrigin( entvars_t* pevBModel );
 
@@ -193,13 +198,15 @@ void CBaseMonster :: BarnacleVictimReleased ( void )
 }
 
 //=========================================================
-// Listen - monsters dig through the active sound list for
+// Listen - monsters dig through the sounds near them for
 // any sounds that may interest them. (smells, too!)
 //=========================================================
 void CBaseMonster :: Listen ( void )
 {
 	int		iSound;
 	int		iMySounds;
+	int		iNearSounds[ MAX_WORLD_SOUNDS ];
+	int		i, cNearSounds;
 	float	hearingSensitivity;
 	CSound	*pCurrentSound;
 
@@ -216,19 +223,21 @@ void CBaseMonster :: Listen ( void )
 		iMySounds &= m_pSchedule->iSoundMask;
 	}
 
-	iSound = CSoundEnt::ActiveList();
-
 	// UNDONE: Clear these here?
 	ClearConditions( bits_COND_HEAR_SOUND | bits_COND_SMELL_FOOD | bits_COND_SMELL );
 	hearingSensitivity = HearingSensitivity( );
 
-	while ( iSound != SOUNDLIST_EMPTY )
+	Vector vecEar = EarPosition();
+	cNearSounds = CSoundEnt::SoundsNearOrigin( vecEar, hearingSensitivity, iNearSounds );
+
+	for ( i = 0 ; i < cNearSounds ; i++ )
 	{
+		iSound = iNearSounds[ i ];
 		pCurrentSound = CSoundEnt::SoundPointerForIndex( iSound );
 
 		if ( pCurrentSound	&& 
 			 ( pCurrentSound->m_iType & iMySounds )	&& 
-			 ( pCurrentSound->m_vecOrigin - EarPosition() ).Length() <= pCurrentSound->m_iVolume * hearingSensitivity )
+			 ( pCurrentSound->m_vecOrigin - vecEar ).Length() <= pCurrentSound->m_iVolume * hearingSensitivity )
 
 		//if ( ( g_pSoundEnt->m_SoundPool[ iSound ].m_iType & iMySounds ) && ( g_pSoundEnt->m_SoundPool[ iSound ].m_vecOrigin - EarPosition()).Length () <= g_pSoundEnt->m_SoundPool[ iSound ].m_iVolume * hearingSensitivity ) 
 		{
@@ -264,9 +273,6 @@ void CBaseMonster :: Listen ( void )
 
 			m_iAudibleList = iSound;
 		}
-
-//		iSound = g_pSoundEnt->m_SoundPool[ iSound ].m_iNext;
-		iSound = pCurrentSound->m_iNext;
 	}
 }
 
@@ -290,6 +296,123 @@ BOOL CBaseMonster :: FValidateHintType ( short sHint )
 	return FALSE;
 }
 
+//=========================================================
+// Line of sight cache. Monsters of one squad or crowd look
+// from nearly the same place at the same targets, so result
+// of the trace is stored by (looker eye cell, target, target
+// eye cell) and shared by all of them until the next frame.
+//=========================================================
+typedef struct
+{
+	float	time;			// gpGlobals->time of the stored result
+	int		eyecell[3];
+	int		targetcell[3];
+	int		target;			// entity index
+	BOOL	visible;
+} loscache_t;
+
+static loscache_t	gLOSCache[LOS_CACHE_SIZE];
+
+static struct
+{
+	float	nextreport;
+	int		traces;		// really traced
+	int		cached;		// taken from cache
+	int		culled;		// rejected by PVS without trace
+} gLOSStats;
+
+static void LOSCell( const Vector &vecPos, int *cell )
+{
+	for ( int i = 0; i < 3; i++ )
+		cell[i] = (int)floor( vecPos[i] / LOS_CELL_SIZE );
+}
+
+static void LOSReportStats( void )
+{
+	if ( gLOSStats.nextreport > gpGlobals->time + 1.0 )
+		gLOSStats.nextreport = 0; // level was changed
+
+	if ( gLOSStats.nextreport > gpGlobals->time )
+		return;
+
+	if ( displaylosstats.value && ( gLOSStats.traces || gLOSStats.cached || gLOSStats.culled ))
+		ALERT( at_console, "LOS: %d traces, %d cached, %d culled by PVS\n", gLOSStats.traces, gLOSStats.cached, gLOSStats.culled );
+
+	gLOSStats.traces = gLOSStats.cached = gLOSStats.culled = 0;
+	gLOSStats.nextreport = gpGlobals->time + 1.0;
+}
+
+//=========================================================
+// ClearLOSCache - called on level start, gpGlobals->time
+// starts over so old results could match the new level
+//=========================================================
+void ClearLOSCache ( void )
+{
+	for ( int i = 0; i < LOS_CACHE_SIZE; i++ )
+		gLOSCache[i].time = -1;	// never matches gpGlobals->time
+
+	gLOSStats.nextreport = 0;
+}
+
+//=========================================================
+// FCachedVisible - the same as FVisible, but the trace
+// result is shared by lookers in the same cell
+//=========================================================
+BOOL FCachedVisible ( CBaseEntity *pLooker, CBaseEntity *pTarget )
+{
+	entvars_t	*pev = pLooker->pev;
+	int			eyecell[3], targetcell[3];
+	int			target;
+	unsigned int hash;
+	loscache_t	*pCache;
+	TraceResult tr;
+
+	if ( FBitSet( pTarget->pev->flags, FL_NOTARGET ) )
+		return FALSE;
+
+	// don't look through water
+	if ( (pev->waterlevel != 3 && pTarget->pev->waterlevel == 3) 
+		|| (pev->waterlevel == 3 && pTarget->pev->waterlevel == 0) )
+		return FALSE;
+
+	Vector vecLookerOrigin = pev->origin + pev->view_ofs;//look through the caller's 'eyes'
+	Vector vecTargetOrigin = pTarget->EyePosition();
+
+	LOSCell( vecLookerOrigin, eyecell );
+	LOSCell( vecTargetOrigin, targetcell );
+	target = pTarget->entindex();
+
+	hash = eyecell[0] * 73856093 ^ eyecell[1] * 19349663 ^ eyecell[2] * 83492791;
+	hash ^= targetcell[0] * 2654435761U ^ targetcell[1] * 40503 ^ targetcell[2] * 97 ^ target * 31;
+	pCache = &gLOSCache[hash & (LOS_CACHE_SIZE - 1)];
+
+	if ( pCache->time == gpGlobals->time && pCache->target == target &&
+		!memcmp( pCache->eyecell, eyecell, sizeof( eyecell )) && !memcmp( pCache->targetcell, targetcell, sizeof( targetcell )) )
+	{
+		gLOSStats.cached++;
+		return pCache->visible;
+	}
+
+	pCache->time = gpGlobals->time;
+	pCache->target = target;
+	memcpy( pCache->eyecell, eyecell, sizeof( eyecell ));
+	memcpy( pCache->targetcell, targetcell, sizeof( targetcell ));
+
+	// world geometry blocks any line between leafs that can't see each other
+	if ( g_physfuncs.pfnBoxInPVS && !g_physfuncs.pfnBoxInPVS( vecLookerOrigin, pTarget->pev->absmin, pTarget->pev->absmax ) )
+	{
+		gLOSStats.culled++;
+		pCache->visible = FALSE;
+		return FALSE;
+	}
+
+	UTIL_TraceLine( vecLookerOrigin, vecTargetOrigin, ignore_monsters, ignore_glass, ENT(pev)/*pentIgnore*/, &tr );
+	gLOSStats.traces++;
+
+	pCache->visible = ( tr.flFraction == 1.0 );
+	return pCache->visible;
+}
+
 //=========================================================
 // Look - Base class monster function to find enemies or 
 // food by sight. iDistance is distance ( in units ) that the 
@@ -311,6 +434,8 @@ void CBaseMonster :: Look ( int iDistance )
 
 	m_pLink = NULL;
 
+	LOSReportStats();
+
 	CBaseEntity	*pSightEnt = NULL;// the current visible entity that we're dealing with
 
 	// See no evil if prisoner is set
@@ -332,7 +457,7 @@ void CBaseMonster :: Look ( int iDistance )
 			{
 				// the looker will want to consider this entity
 				// don't check anything else about an entity that can't be seen, or an entity that you don't care about.
-				if ( IRelationship( pSightEnt ) != R_NO && FInViewCone( pSightEnt ) && !FBitSet( pSightEnt->pev->flags, FL_NOTARGET ) && FVisible( pSightEnt ) )
+				if ( IRelationship( pSightEnt ) != R_NO && FInViewCone( pSightEnt ) && !FBitSet( pSightEnt->pev->flags, FL_NOTARGET ) && FCachedVisible( this, pSightEnt ) )
 				{
 					if ( pSightEnt->IsPlayer() )
 					{
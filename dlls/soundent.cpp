@@ -23,6 +23,23 @@ LINK_ENTITY_TO_CLASS( soundent, CSoundEnt );
 
 CSoundEnt *pSoundEnt;
 
+//=========================================================
+// SoundCell - grid cell of the coordinate
+//=========================================================
+static int SoundCell( float flCoord )
+{
+	return (int)floor( flCoord / SOUND_CELL_SIZE );
+}
+
+//=========================================================
+// SoundBucket - grid bucket of the (x,y) cell. Far cells 
+// may share the bucket, so distance must be checked anyway.
+//=========================================================
+static int SoundBucket( int x, int y )
+{
+	return ( x * 73856093 ^ y * 19349663 ) & ( SOUND_GRID_SIZE - 1 );
+}
+
 //=========================================================
 // CSound - Clear - zeros all fields for a sound
 //=========================================================
@@ -33,6 +50,8 @@ void CSound :: Clear ( void )
 	m_iVolume		= 0;
 	m_flExpireTime	= 0;
 	m_iNext			= SOUNDLIST_EMPTY;
+	m_iPrev			= SOUNDLIST_EMPTY;
+	m_iBucket		= SOUNDLIST_EMPTY;
 	m_iNextAudible	= 0;
 }
 
@@ -86,35 +105,33 @@ void CSoundEnt :: Spawn( void )
 }
 
 //=========================================================
-// Think - at interval, the entire active sound list is checked
-// for sounds that have ExpireTimes less than or equal
-// to the current world time, and these sounds are deallocated.
+// Think - at interval, sounds that have ExpireTimes less than
+// or equal to the current world time are taken from the top 
+// of the expire queue, and these sounds are deallocated.
 //=========================================================
 void CSoundEnt :: Think ( void )
 {
-	int iSound;
-	int iPreviousSound;
+	int i;
+	BOOL fExpired = FALSE;
 
 	pev->nextthink = gpGlobals->time + 0.3;// how often to check the sound list.
 
-	iPreviousSound = SOUNDLIST_EMPTY;
-	iSound = m_iActiveSound; 
-
-	while ( iSound != SOUNDLIST_EMPTY )
+	while ( m_cExpireQueue > 0 && m_SoundPool[ m_ExpireQueue[ 0 ] ].m_flExpireTime <= gpGlobals->time )
 	{
-		if ( m_SoundPool[ iSound ].m_flExpireTime <= gpGlobals->time && m_SoundPool[ iSound ].m_flExpireTime != SOUND_NEVER_EXPIRE )
-		{
-			int iNext = m_SoundPool[ iSound ].m_iNext;
+		// move this sound back into the free list
+		FreeSound( PopExpire() );
+		fExpired = TRUE;
+	}
 
-			// move this sound back into the free list
-			FreeSound( iSound, iPreviousSound );
+	if ( fExpired )
+	{
+		// the loudest sound may be gone, this bounds the grid search
+		m_iMaxVolume = 0;
 
-			iSound = iNext;
-		}
-		else
+		for ( i = 0 ; i < MAX_WORLD_SOUNDS ; i++ )
 		{
-			iPreviousSound = iSound;
-			iSound = m_SoundPool[ iSound ].m_iNext;
+			if ( m_SoundPool[ i ].m_iBucket != SOUNDLIST_EMPTY )
+				m_iMaxVolume = max( m_iMaxVolume, m_SoundPool[ i ].m_iVolume );
 		}
 	}
 
@@ -134,39 +151,117 @@ void CSoundEnt :: Precache ( void )
 }
 
 //=========================================================
-// FreeSound - clears the passed active sound and moves it 
-// to the top of the free list. TAKE CARE to only call this
-// function for sounds in the Active list!!
+// FreeSound - unlinks the passed active sound from its grid 
+// bucket and moves it to the top of the free list. TAKE CARE
+// to only call this function for sounds taken from the
+// expire queue!!
 //=========================================================
-void CSoundEnt :: FreeSound ( int iSound, int iPrevious )
+void CSoundEnt :: FreeSound ( int iSound )
 {
+	CSound *pSound;
+
 	if ( !pSoundEnt )
 	{
 		// no sound ent!
 		return;
 	}
 
-	if ( iPrevious != SOUNDLIST_EMPTY )
-	{
-		// iSound is not the head of the active list, so
-		// must fix the index for the Previous sound
-//		pSoundEnt->m_SoundPool[ iPrevious ].m_iNext = m_SoundPool[ iSound ].m_iNext;
-		pSoundEnt->m_SoundPool[ iPrevious ].m_iNext = pSoundEnt->m_SoundPool[ iSound ].m_iNext;
-	}
-	else 
+	pSound = &pSoundEnt->m_SoundPool[ iSound ];
+
+	if ( pSound->m_iBucket != SOUNDLIST_EMPTY )
 	{
-		// the sound we're freeing IS the head of the active list.
-		pSoundEnt->m_iActiveSound = pSoundEnt->m_SoundPool [ iSound ].m_iNext;
+		if ( pSound->m_iPrev != SOUNDLIST_EMPTY )
+			pSoundEnt->m_SoundPool[ pSound->m_iPrev ].m_iNext = pSound->m_iNext;
+		else
+			pSoundEnt->m_Grid[ pSound->m_iBucket ] = pSound->m_iNext;
+
+		if ( pSound->m_iNext != SOUNDLIST_EMPTY )
+			pSoundEnt->m_SoundPool[ pSound->m_iNext ].m_iPrev = pSound->m_iPrev;
+
+		pSound->m_iBucket = SOUNDLIST_EMPTY;
 	}
 
 	// make iSound the head of the Free list.
-	pSoundEnt->m_SoundPool[ iSound ].m_iNext = pSoundEnt->m_iFreeSound;
+	pSound->m_iNext = pSoundEnt->m_iFreeSound;
 	pSoundEnt->m_iFreeSound = iSound;
+	pSoundEnt->m_cActiveSounds--;
+}
+
+//=========================================================
+// LinkSound - puts the sound into the grid bucket of its
+// origin
+//=========================================================
+void CSoundEnt :: LinkSound ( int iSound )
+{
+	CSound *pSound = &m_SoundPool[ iSound ];
+	int iBucket = SoundBucket( SoundCell( pSound->m_vecOrigin.x ), SoundCell( pSound->m_vecOrigin.y ) );
+
+	pSound->m_iBucket = iBucket;
+	pSound->m_iPrev = SOUNDLIST_EMPTY;
+	pSound->m_iNext = m_Grid[ iBucket ];
+
+	if ( m_Grid[ iBucket ] != SOUNDLIST_EMPTY )
+		m_SoundPool[ m_Grid[ iBucket ] ].m_iPrev = iSound;
+
+	m_Grid[ iBucket ] = iSound;
+	m_iMaxVolume = max( m_iMaxVolume, pSound->m_iVolume );
+}
+
+//=========================================================
+// PushExpire - adds the sound to the expire queue, which 
+// is a binary heap with the earliest ExpireTime on top
+//=========================================================
+void CSoundEnt :: PushExpire ( int iSound )
+{
+	float flExpireTime = m_SoundPool[ iSound ].m_flExpireTime;
+	int i = m_cExpireQueue++;
+
+	while ( i > 0 )
+	{
+		int iParent = ( i - 1 ) / 2;
+
+		if ( m_SoundPool[ m_ExpireQueue[ iParent ] ].m_flExpireTime <= flExpireTime )
+			break;
+
+		m_ExpireQueue[ i ] = m_ExpireQueue[ iParent ];
+		i = iParent;
+	}
+
+	m_ExpireQueue[ i ] = iSound;
 }
 
 //=========================================================
-// IAllocSound - moves a sound from the Free list to the 
-// Active list returns the index of the alloc'd sound
+// PopExpire - removes the sound which expires first from 
+// the expire queue and returns its index
+//=========================================================
+int CSoundEnt :: PopExpire ( void )
+{
+	int iSound = m_ExpireQueue[ 0 ];
+	int iLast = m_ExpireQueue[ --m_cExpireQueue ];
+	float flExpireTime = m_SoundPool[ iLast ].m_flExpireTime;
+	int i = 0;
+	int iChild;
+
+	while ( ( iChild = i * 2 + 1 ) < m_cExpireQueue )
+	{
+		if ( iChild + 1 < m_cExpireQueue && m_SoundPool[ m_ExpireQueue[ iChild + 1 ] ].m_flExpireTime < m_SoundPool[ m_ExpireQueue[ iChild ] ].m_flExpireTime )
+			iChild++;
+
+		if ( flExpireTime <= m_SoundPool[ m_ExpireQueue[ iChild ] ].m_flExpireTime )
+			break;
+
+		m_ExpireQueue[ i ] = m_ExpireQueue[ iChild ];
+		i = iChild;
+	}
+
+	m_ExpireQueue[ i ] = iLast;
+
+	return iSound;
+}
+
+//=========================================================
+// IAllocSound - takes a sound from the Free list, 
+// returns the index of the alloc'd sound
 //=========================================================
 int CSoundEnt :: IAllocSound( void )
 {
@@ -179,16 +274,18 @@ int CSoundEnt :: IAllocSound( void )
 		return SOUNDLIST_EMPTY;
 	}
 
-	// there is at least one sound available, so move it to the
-	// Active sound list, and return its SoundPool index.
+	// there is at least one sound available, so take it
+	// and return its SoundPool index.
 	
 	iNewSound = m_iFreeSound;// copy the index of the next free sound
 
 	m_iFreeSound = m_SoundPool[ m_iFreeSound ].m_iNext;// move the index down into the free list. 
 
-	m_SoundPool[ iNewSound ].m_iNext = m_iActiveSound;// point the new sound at the top of the active list.
+	m_SoundPool[ iNewSound ].m_iNext = SOUNDLIST_EMPTY;// not linked anywhere until InsertSound
+	m_SoundPool[ iNewSound ].m_iPrev = SOUNDLIST_EMPTY;
+	m_SoundPool[ iNewSound ].m_iBucket = SOUNDLIST_EMPTY;
 
-	m_iActiveSound = iNewSound;// now make the new sound the top of the active list. You're done.
+	m_cActiveSounds++;
 
 	return iNewSound;
 }
@@ -219,6 +316,13 @@ void CSoundEnt :: InsertSound ( int iType, const Vector &vecOrigin, int iVolume,
 	pSoundEnt->m_SoundPool[ iThisSound ].m_iType = iType;
 	pSoundEnt->m_SoundPool[ iThisSound ].m_iVolume = iVolume;
 	pSoundEnt->m_SoundPool[ iThisSound ].m_flExpireTime = gpGlobals->time + flDuration;
+
+	pSoundEnt->LinkSound( iThisSound );
+
+	if ( pSoundEnt->m_SoundPool[ iThisSound ].m_flExpireTime != SOUND_NEVER_EXPIRE )
+	{
+		pSoundEnt->PushExpire( iThisSound );
+	}
 }
 
 //=========================================================
@@ -232,7 +336,15 @@ void CSoundEnt :: Initialize ( void )
 
 	m_cLastActiveSounds;
 	m_iFreeSound = 0;
-	m_iActiveSound = SOUNDLIST_EMPTY;
+	m_cActiveSounds = 0;
+	m_cClientSounds = 0;
+	m_iMaxVolume = 0;
+	m_cExpireQueue = 0;
+
+	for ( i = 0 ; i < SOUND_GRID_SIZE ; i++ )
+	{
+		m_Grid[ i ] = SOUNDLIST_EMPTY;
+	}
 
 	for ( i = 0 ; i < MAX_WORLD_SOUNDS ; i++ )
 	{// clear all sounds, and link them into the free sound list.
@@ -255,6 +367,7 @@ void CSoundEnt :: Initialize ( void )
 		}
 
 		pSoundEnt->m_SoundPool[ iSound ].m_flExpireTime = SOUND_NEVER_EXPIRE;
+		pSoundEnt->m_cClientSounds++;
 	}
 
 	if ( CVAR_GET_FLOAT("displaysoundlist") == 1 )
@@ -282,7 +395,8 @@ int CSoundEnt :: ISoundsInList ( int iListType )
 	}
 	else if ( iListType == SOUNDLISTTYPE_ACTIVE )
 	{
-		iThisSound = m_iActiveSound;
+		// active sounds are spread over the grid
+		return m_cActiveSounds;
 	}
 	else
 	{
@@ -307,16 +421,72 @@ int CSoundEnt :: ISoundsInList ( int iListType )
 }
 
 //=========================================================
-// ActiveList - returns the head of the active sound list
+// SoundsNearOrigin - fills the list with client sounds and
+// sounds from the grid buckets which are in reach of the 
+// loudest sound. List must hold MAX_WORLD_SOUNDS indices,
+// returns the number of sounds. Caller still must check the
+// distance to each sound.
 //=========================================================
-int CSoundEnt :: ActiveList ( void )
+int CSoundEnt :: SoundsNearOrigin( const Vector &vecOrigin, float flSensitivity, int *pList )
 {
+	unsigned int visited[ SOUND_GRID_SIZE / 32 ];
+	int mins[ 2 ], maxs[ 2 ];
+	int i, x, y, iBucket, iSound;
+	int cSounds = 0;
+	float flRadius;
+
 	if ( !pSoundEnt )
 	{
-		return SOUNDLIST_EMPTY;
+		return 0;
+	}
+
+	// client sounds are moving with players and are never in the grid
+	for ( i = 0 ; i < pSoundEnt->m_cClientSounds ; i++ )
+	{
+		pList[ cSounds++ ] = i;
+	}
+
+	flRadius = pSoundEnt->m_iMaxVolume * flSensitivity;
+
+	for ( i = 0 ; i < 2 ; i++ )
+	{
+		mins[ i ] = SoundCell( vecOrigin[ i ] - flRadius );
+		maxs[ i ] = SoundCell( vecOrigin[ i ] + flRadius );
+	}
+
+	// far cells may share the bucket, so mark buckets first
+	if ( maxs[ 0 ] - mins[ 0 ] >= SOUND_GRID_SIZE || maxs[ 1 ] - mins[ 1 ] >= SOUND_GRID_SIZE ||
+		( maxs[ 0 ] - mins[ 0 ] + 1 ) * ( maxs[ 1 ] - mins[ 1 ] + 1 ) >= SOUND_GRID_SIZE )
+	{
+		// covers more cells than there are buckets, take everything
+		memset( visited, 0xFF, sizeof( visited ) );
+	}
+	else
+	{
+		memset( visited, 0, sizeof( visited ) );
+
+		for ( x = mins[ 0 ] ; x <= maxs[ 0 ] ; x++ )
+		{
+			for ( y = mins[ 1 ] ; y <= maxs[ 1 ] ; y++ )
+			{
+				iBucket = SoundBucket( x, y );
+				visited[ iBucket >> 5 ] |= 1 << ( iBucket & 31 );
+			}
+		}
+	}
+
+	for ( iBucket = 0 ; iBucket < SOUND_GRID_SIZE ; iBucket++ )
+	{
+		if ( !( visited[ iBucket >> 5 ] & ( 1 << ( iBucket & 31 ) ) ) )
+			continue;
+
+		for ( iSound = pSoundEnt->m_Grid[ iBucket ] ; iSound != SOUNDLIST_EMPTY ; iSound = pSoundEnt->m_SoundPool[ iSound ].m_iNext )
+		{
+			pList[ cSounds++ ] = iSound;
+		}
 	}
 
-	return pSoundEnt->m_iActiveSound;
+	return cSounds;
 }
 
 //=========================================================
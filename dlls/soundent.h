@@ -38,6 +38,9 @@
 
 #define	SOUND_NEVER_EXPIRE	-1 // with this set as a sound's ExpireTime, the sound will never expire.
 
+#define SOUND_CELL_SIZE		512 // sounds are bucketed by the (x,y) cell of their origin
+#define SOUND_GRID_SIZE		64 // number of buckets, must be power of two
+
 //=========================================================
 // CSound - an instance of a sound in the world.
 //=========================================================
@@ -52,7 +55,9 @@ public:
 	int		m_iType;		// what type of sound this is
 	int		m_iVolume;		// how loud the sound is
 	float	m_flExpireTime;	// when the sound should be purged from the list
-	int		m_iNext;		// index of next sound in this list ( Active or Free )
+	int		m_iNext;		// index of next sound in this list ( grid bucket or Free )
+	int		m_iPrev;		// index of previous sound in the grid bucket
+	int		m_iBucket;		// grid bucket the sound is linked to, SOUNDLIST_EMPTY for client sounds
 	int		m_iNextAudible;	// temporary link that monsters use to build a list of audible sounds
 
 	BOOL	FIsSound( void );
@@ -74,22 +79,31 @@ public:
 	void Initialize ( void );
 	
 	static void		InsertSound ( int iType, const Vector &vecOrigin, int iVolume, float flDuration );
-	static void		FreeSound ( int iSound, int iPrevious );
-	static int		ActiveList( void );// return the head of the active list
+	static void		FreeSound ( int iSound );
 	static int		FreeList( void );// return the head of the free list
+	static int		SoundsNearOrigin( const Vector &vecOrigin, float flSensitivity, int *pList );// fill the list with sounds which may be heard here
 	static CSound*	SoundPointerForIndex( int iIndex );// return a pointer for this index in the sound list
 	static int		ClientSoundIndex ( edict_t *pClient );
 
-	BOOL	IsEmpty( void ) { return m_iActiveSound == SOUNDLIST_EMPTY; }
+	BOOL	IsEmpty( void ) { return m_cActiveSounds == 0; }
 	int		ISoundsInList ( int iListType );
 	int		IAllocSound ( void );
 	virtual int		ObjectCaps( void ) { return FCAP_DONT_SAVE; }
 	
 	int		m_iFreeSound;	// index of the first sound in the free sound list
-	int		m_iActiveSound; // indes of the first sound in the active sound list
+	int		m_cActiveSounds; // number of allocated sounds, client sounds included
+	int		m_cClientSounds; // sounds reserved for clients, they are first in the pool
+	int		m_iMaxVolume;	// no sound in the grid is louder than this
 	int		m_cLastActiveSounds; // keeps track of the number of active sounds at the last update. (for diagnostic work)
 	BOOL	m_fShowReport; // if true, dump information about free/active sounds.
 
 private:
+	void	LinkSound ( int iSound );
+	void	PushExpire ( int iSound );
+	int		PopExpire ( void );
+
 	CSound		m_SoundPool[ MAX_WORLD_SOUNDS ];
+	int			m_Grid[ SOUND_GRID_SIZE ];// first sound in each bucket
+	int			m_ExpireQueue[ MAX_WORLD_SOUNDS ];// binary heap of sounds ordered by expire time
+	int			m_cExpireQueue;
 };
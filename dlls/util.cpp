@@ -25,11 +25,13 @@
 #include "cbase.h"
 #include "saverestore.h"
 #include <time.h>
+#include <ctype.h>
 #include "shake.h"
 #include "decals.h"
 #include "player.h"
 #include "weapons.h"
 #include "gamerules.h"
+#include "physcallback.h"
 
 float UTIL_WeaponTimeBase( void )
 {
@@ -401,6 +403,8 @@ void UTIL_MoveToOrigin( edict_t *pent, const Vector &vecGoal, float flDist, int
 }
 
 
+#define MAX_AREA_EDICTS	512
+
 int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, const Vector &maxs, int flagMask )
 {
 	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
@@ -409,6 +413,26 @@ int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, co
 
 	count = 0;
 
+	// engine walks only the area tree nodes that touch the box
+	if ( g_physfuncs.pfnEntitiesInBox )
+	{
+		edict_t *pEdicts[MAX_AREA_EDICTS];
+		int numEdicts = g_physfuncs.pfnEntitiesInBox( mins, maxs, pEdicts, MAX_AREA_EDICTS, flagMask );
+
+		// edicts without private data don't take the caller's slots
+		for ( int i = 0; i < numEdicts && count < listMax; i++ )
+		{
+			pEntity = CBaseEntity::Instance( pEdicts[i] );
+			if ( !pEntity )
+				continue;
+
+			pList[ count ] = pEntity;
+			count++;
+		}
+
+		return count;
+	}
+
 	if ( !pEdict )
 		return count;
 
@@ -443,16 +467,73 @@ int UTIL_EntitiesInBox( CBaseEntity **pList, int listMax, const Vector &mins, co
 }
 
 
+// Use origin for X & Y since they are centered for all monsters
+static BOOL UTIL_MonsterInSphere( edict_t *pEdict, const Vector &center, float radiusSquared )
+{
+	float		distance, delta;
+
+	// Now X
+	delta = center.x - pEdict->v.origin.x;//(pEdict->v.absmin.x + pEdict->v.absmax.x)*0.5;
+	delta *= delta;
+
+	if ( delta > radiusSquared )
+		return FALSE;
+	distance = delta;
+	
+	// Now Y
+	delta = center.y - pEdict->v.origin.y;//(pEdict->v.absmin.y + pEdict->v.absmax.y)*0.5;
+	delta *= delta;
+
+	distance += delta;
+	if ( distance > radiusSquared )
+		return FALSE;
+
+	// Now Z
+	delta = center.z - (pEdict->v.absmin.z + pEdict->v.absmax.z)*0.5;
+	delta *= delta;
+
+	distance += delta;
+	if ( distance > radiusSquared )
+		return FALSE;
+
+	return TRUE;
+}
+
 int UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &center, float radius )
 {
 	edict_t		*pEdict = g_engfuncs.pfnPEntityOfEntIndex( 1 );
 	CBaseEntity *pEntity;
 	int			count;
-	float		distance, delta;
 
 	count = 0;
 	float radiusSquared = radius * radius;
 
+	// take candidates from the box around sphere
+	if ( g_physfuncs.pfnEntitiesInBox )
+	{
+		edict_t *pEdicts[MAX_AREA_EDICTS];
+		Vector delta = Vector( radius, radius, radius );
+		int numEdicts = g_physfuncs.pfnEntitiesInBox( center - delta, center + delta, pEdicts, MAX_AREA_EDICTS, FL_CLIENT|FL_MONSTER );
+
+		for ( int i = 0; i < numEdicts; i++ )
+		{
+			if ( !UTIL_MonsterInSphere( pEdicts[i], center, radiusSquared ) )
+				continue;
+
+			pEntity = CBaseEntity::Instance( pEdicts[i] );
+			if ( !pEntity )
+				continue;
+
+			pList[ count ] = pEntity;
+			count++;
+
+			if ( count >= listMax )
+				return count;
+		}
+
+		return count;
+	}
+
 	if ( !pEdict )
 		return count;
 
@@ -464,29 +545,7 @@ int UTIL_MonstersInSphere( CBaseEntity **pList, int listMax, const Vector &cente
 		if ( !(pEdict->v.flags & (FL_CLIENT|FL_MONSTER)) )	// Not a client/monster ?
 			continue;
 
-		// Use origin for X & Y since they are centered for all monsters
-		// Now X
-		delta = center.x - pEdict->v.origin.x;//(pEdict->v.absmin.x + pEdict->v.absmax.x)*0.5;
-		delta *= delta;
-
-		if ( delta > radiusSquared )
-			continue;
-		distance = delta;
-		
-		// Now Y
-		delta = center.y - pEdict->v.origin.y;//(pEdict->v.absmin.y + pEdict->v.absmax.y)*0.5;
-		delta *= delta;
-
-		distance += delta;
-		if ( distance > radiusSquared )
-			continue;
-
-		// Now Z
-		delta = center.z - (pEdict->v.absmin.z + pEdict->v.absmax.z)*0.5;
-		delta *= delta;
-
-		distance += delta;
-		if ( distance > radiusSquared )
+		if ( !UTIL_MonsterInSphere( pEdict, center, radiusSquared ) )
 			continue;
 
 		pEntity = CBaseEntity::Instance(pEdict);
@@ -1665,6 +1724,96 @@ static int gSizes[FIELD_TYPECOUNT] =
 };
 
 
+// Field name lookup, built once for each TYPEDESCRIPTION array
+#define FIELDMAP_HASH_SIZE		64		// per array, must be power of two
+#define FIELDMAP_TABLE_SIZE		1024	// arrays, must be power of two
+
+typedef struct fieldmap_s
+{
+	TYPEDESCRIPTION		*pFields;
+	int					fieldCount;
+	short				hash[FIELDMAP_HASH_SIZE];	// first field with this hash, -1 if none
+	short				*pNext;						// next field with same hash
+	struct fieldmap_s	*pNextMap;
+} fieldmap_t;
+
+static fieldmap_t *gFieldMaps[FIELDMAP_TABLE_SIZE];
+
+// case insensitive like stricmp() in field lookups
+static unsigned int FieldNameHash( const char *pszName )
+{
+	unsigned int	hash = 0;
+
+	while ( *pszName )
+		hash = hash * 31 + tolower( *pszName++ );
+
+	return hash & (FIELDMAP_HASH_SIZE - 1);
+}
+
+static fieldmap_t *FieldMapForFields( TYPEDESCRIPTION *pFields, int fieldCount )
+{
+	unsigned int	slot = ((size_t)pFields >> 4) & (FIELDMAP_TABLE_SIZE - 1);
+	fieldmap_t		*pMap;
+	int				i, hash;
+
+	for ( pMap = gFieldMaps[slot]; pMap; pMap = pMap->pNextMap )
+	{
+		if ( pMap->pFields == pFields && pMap->fieldCount == fieldCount )
+			return pMap;
+	}
+
+	// save data arrays are static, so the map is never freed
+	pMap = new fieldmap_t;
+	pMap->pFields = pFields;
+	pMap->fieldCount = fieldCount;
+	pMap->pNext = new short[fieldCount];
+	memset( pMap->hash, 0xFF, sizeof( pMap->hash ) );
+
+	for ( i = fieldCount - 1; i >= 0; i-- )
+	{
+		hash = FieldNameHash( pFields[i].fieldName );
+		pMap->pNext[i] = pMap->hash[hash];
+		pMap->hash[hash] = i;
+	}
+
+	pMap->pNextMap = gFieldMaps[slot];
+	gFieldMaps[slot] = pMap;
+
+	return pMap;
+}
+
+// Returns the first field named pName, searching from startField and wrapping around
+static int FindFieldIndex( TYPEDESCRIPTION *pFields, int fieldCount, int startField, const char *pName )
+{
+	fieldmap_t	*pMap;
+	int			i, dist, best = -1, bestDist = fieldCount;
+
+	if ( fieldCount <= 0 )
+		return -1;
+
+	// Most data is read in the same order it was written
+	if ( startField < fieldCount && !stricmp( pFields[startField].fieldName, pName ) )
+		return startField;
+
+	pMap = FieldMapForFields( pFields, fieldCount );
+
+	for ( i = pMap->hash[ FieldNameHash( pName ) ]; i != -1; i = pMap->pNext[i] )
+	{
+		if ( stricmp( pFields[i].fieldName, pName ) )
+			continue;
+
+		dist = (i - startField + fieldCount) % fieldCount;
+		if ( dist < bestDist )
+		{
+			bestDist = dist;
+			best = i;
+		}
+	}
+
+	return best;
+}
+
+
 // Base class includes common SAVERESTOREDATA pointer, and manages the entity table
 CSaveRestoreBuffer :: CSaveRestoreBuffer( void )
 {
@@ -1703,19 +1852,67 @@ int	CSaveRestoreBuffer :: EntityIndex( EOFFSET eoLookup )
 }
 
 
+// Entity table lookups for the current save or restore. The table is filled while
+// entities are restored, so cached entries are checked and rebuilt on a miss
+static struct
+{
+	ENTITYTABLE		*pTable;
+	int				tableCount;
+	int				maxEntities;
+	int				*pEdictIndex;	// table index by edict number
+	int				*pIdIndex;		// table index by entity id
+} gEntityTableCache;
+
+static void EntityTableCacheSetup( SAVERESTOREDATA *pdata )
+{
+	int i;
+
+	if ( gEntityTableCache.pTable == pdata->pTable && gEntityTableCache.tableCount == pdata->tableCount )
+		return;
+
+	if ( gEntityTableCache.maxEntities != gpGlobals->maxEntities )
+	{
+		delete [] gEntityTableCache.pEdictIndex;
+		delete [] gEntityTableCache.pIdIndex;
+		gEntityTableCache.maxEntities = gpGlobals->maxEntities;
+		gEntityTableCache.pEdictIndex = new int[gEntityTableCache.maxEntities];
+		gEntityTableCache.pIdIndex = new int[gEntityTableCache.maxEntities];
+	}
+
+	gEntityTableCache.pTable = pdata->pTable;
+	gEntityTableCache.tableCount = pdata->tableCount;
+
+	for ( i = 0; i < gEntityTableCache.maxEntities; i++ )
+		gEntityTableCache.pEdictIndex[i] = gEntityTableCache.pIdIndex[i] = -1;
+}
+
 int	CSaveRestoreBuffer :: EntityIndex( edict_t *pentLookup )
 {
 	if ( !m_pdata || pentLookup == NULL )
 		return -1;
 
-	int i;
+	int i, num;
 	ENTITYTABLE *pTable;
 
+	EntityTableCacheSetup( m_pdata );
+
+	num = ENTINDEX( pentLookup );
+	if ( num >= 0 && num < gEntityTableCache.maxEntities )
+	{
+		i = gEntityTableCache.pEdictIndex[num];
+		if ( i >= 0 && i < m_pdata->tableCount && m_pdata->pTable[i].pent == pentLookup )
+			return i;
+	}
+
 	for ( i = 0; i < m_pdata->tableCount; i++ )
 	{
 		pTable = m_pdata->pTable + i;
 		if ( pTable->pent == pentLookup )
+		{
+			if ( num >= 0 && num < gEntityTableCache.maxEntities )
+				gEntityTableCache.pEdictIndex[num] = i;
 			return i;
+		}
 	}
 	return -1;
 }
@@ -1729,11 +1926,24 @@ edict_t *CSaveRestoreBuffer :: EntityFromIndex( int entityIndex )
 	int i;
 	ENTITYTABLE *pTable;
 
+	EntityTableCacheSetup( m_pdata );
+
+	if ( entityIndex < gEntityTableCache.maxEntities )
+	{
+		i = gEntityTableCache.pIdIndex[entityIndex];
+		if ( i >= 0 && i < m_pdata->tableCount && m_pdata->pTable[i].id == entityIndex )
+			return m_pdata->pTable[i].pent;
+	}
+
 	for ( i = 0; i < m_pdata->tableCount; i++ )
 	{
 		pTable = m_pdata->pTable + i;
 		if ( pTable->id == entityIndex )
+		{
+			if ( entityIndex < gEntityTableCache.maxEntities )
+				gEntityTableCache.pIdIndex[entityIndex] = i;
 			return pTable->pent;
+		}
 	}
 	return NULL;
 }
@@ -1982,7 +2192,12 @@ void EntvarsKeyvalue( entvars_t *pev, KeyValueData *pkvd )
 	int i;
 	TYPEDESCRIPTION		*pField;
 
-	for ( i = 0; i < ENTVARS_COUNT; i++ )
+	// Start the scan right at the matching field, or skip it if there is none
+	i = FindFieldIndex( gEntvarsDescription, ENTVARS_COUNT, 0, pkvd->szKeyName );
+	if ( i < 0 )
+		i = ENTVARS_COUNT;
+
+	for ( ; i < ENTVARS_COUNT; i++ )
 	{
 		pField = &gEntvarsDescription[i];
 
@@ -2225,7 +2440,11 @@ int CRestore::ReadField( void *pBaseData, TYPEDESCRIPTION *pFields, int fieldCou
 			position = m_pdata->vecLandmarkOffset;
 	}
 
-	for ( i = 0; i < fieldCount; i++ )
+	// Start the scan right at the first matching field, or skip it if there is none
+	fieldNumber = FindFieldIndex( pFields, fieldCount, startField, pName );
+	i = ( fieldNumber < 0 ) ? fieldCount : (fieldNumber - startField + fieldCount) % fieldCount;
+
+	for ( ; i < fieldCount; i++ )
 	{
 		fieldNumber = (i+startField)%fieldCount;
 		pTest = &pFields[ fieldNumber ];
@@ -44,6 +44,7 @@ CGlobalState					gGlobalState;
 extern DLL_GLOBAL	int			gDisplayTitle;
 
 extern void W_Precache(void);
+extern void ClearLOSCache(void);
 
 //
 // This must match the list in util.h
@@ -479,6 +480,9 @@ void CWorld :: Spawn( void )
 void CWorld :: Precache( void )
 {
 	g_pLastSpawn = NULL;
+
+	// monster line of sight results are valid for the current level only
+	ClearLOSCache();
 	
 #if 1
 	CVAR_SET_STRING("sv_gravity", "800"); // 67ft/sec
@@ -845,13 +849,24 @@ static physics_interface_t gPhysicsInterface =
 
 int Server_GetPhysicsInterface( int iVersion, server_physics_api_t *pfuncsFromEngine, physics_interface_t *pFunctionTable )
 {
-	if ( !pFunctionTable || !pfuncsFromEngine || iVersion != SV_PHYSICS_INTERFACE_VERSION )
+	size_t	iSize;
+
+	if ( !pFunctionTable || !pfuncsFromEngine )
 	{
 		return FALSE;
 	}
 
+	// older engine has a shorter table, missed functions stay NULL
+	if ( iVersion == SV_PHYSICS_INTERFACE_VERSION )
+		iSize = sizeof( server_physics_api_t );
+	else if ( iVersion == SV_PHYSICS_INTERFACE_VERSION_6 )
+		iSize = offsetof( server_physics_api_t, pfnEntitiesInBox );
+	else
+		return FALSE;
+
 	// copy new physics interface
-	memcpy(&g_physfuncs, pfuncsFromEngine, sizeof(server_physics_api_t));
+	memset( &g_physfuncs, 0, sizeof( server_physics_api_t ));
+	memcpy( &g_physfuncs, pfuncsFromEngine, iSize );
 
 	// fill engine callbacks
 	memcpy( pFunctionTable, &gPhysicsInterface, sizeof( physics_interface_t ) );
@@ -33,6 +33,9 @@ GNU General Public License for more details.
 #define IDEMOHEADER		(('M'<<24)+('E'<<16)+('D'<<8)+'I') // little-endian "IDEM"
 #define DEMO_PROTOCOL	2
 
+#define IDEMOSEEK		(('K'<<24)+('E'<<16)+('E'<<8)+'S') // little-endian "SEEK"
+#define MAX_DEMO_KEYFRAMES	65536
+
 const char *demo_cmd[dem_lastcmd+1] =
 {
 	"dem_unknown",
@@ -71,6 +74,15 @@ typedef struct
 	int		numentries;	// number of tracks
 } demodirectory_t;
 
+// seek index is written after the directory, old demos doesn't have it
+typedef struct
+{
+	float		time;		// demo time since start of first level
+	float		timestamp;	// time of message header, relative to level start
+	int		level;		// number of dem_jumptime before this keyframe
+	int		offset;		// file offset of keyframe message
+} demokeyframe_t;
+
 // add angles
 typedef struct
 {
@@ -94,8 +106,43 @@ struct
 	// interpolation stuff
 	demoangle_t	cmds[ANGLE_BACKUP];
 	int		angle_position;
+
+	// seek index
+	demokeyframe_t	*keyframes;
+	int		numkeyframes;
+	int		maxkeyframes;
+	qboolean		keyframe;		// current message contains non-delta entities
+	double		lastkeyframe;	// cls.demotime of last written keyframe
+	float		levelstart;	// demo time when current level was started
+	float		msgtime;		// timestamp of last written or read message
+	int		level;
+
+	// fast-forward
+	qboolean		seeking;		// parse messages without waiting
+	float		seektime;
+	int		seeklevel;	// level where seek index was checked
 } demo;
 
+typedef struct
+{
+	int		count;
+	int		bytes;
+	double		time;
+} demobench_t;
+
+// benchdemo results
+static struct
+{
+	demobench_t	svc[256];		// engine and user messages
+	demobench_t	emit;		// interpolation and linking entities
+	int		messages;
+	int		bytes;
+	int		startframe;
+	int		lastframe;	// host.framecount of last read message
+	double		starttime;
+	qboolean		quit;
+} bench;
+
 /*
 ====================
 CL_StartupDemoHeader
@@ -171,6 +218,9 @@ overwrite host.frametime
 */
 double CL_GetDemoFramerate( void )
 {
+	if( cls.demobench )
+		return 0.0; // unlimited
+
 	return bound( MIN_FPS, demo.header.host_fps, MAX_FPS );
 }
 
@@ -194,6 +244,17 @@ void CL_WriteDemoCmdHeader( byte cmd, file_t *file )
 	// time offset
 	dt = (float)(CL_GetDemoRecordClock() - demo.starttime);
 	FS_Write( file, &dt, sizeof( float ));
+
+	if( file == cls.demofile )
+	{
+		// track demo time the same way as playback does
+		if( cmd == dem_jumptime )
+		{
+			demo.levelstart += demo.msgtime;
+			demo.level++;
+		}
+		demo.msgtime = dt;
+	}
 }
 
 /*
@@ -267,6 +328,115 @@ void CL_WriteDemoSequence( file_t *file )
 	FS_Write( file, &cls.netchan.last_reliable_sequence, sizeof( int ));
 }
 
+/*
+====================
+CL_FreeDemoKeyframes
+====================
+*/
+static void CL_FreeDemoKeyframes( void )
+{
+	if( demo.keyframes )
+		Mem_Free( demo.keyframes );
+
+	demo.keyframes = NULL;
+	demo.numkeyframes = 0;
+	demo.maxkeyframes = 0;
+}
+
+/*
+====================
+CL_DemoMarkKeyframe
+
+called on non-delta packet entities,
+recorded message will be a seek keyframe
+====================
+*/
+void CL_DemoMarkKeyframe( void )
+{
+	if( !cls.demorecording )
+		return;
+
+	cls.demokeyframe = false;
+	demo.keyframe = true;
+}
+
+/*
+====================
+CL_WriteDemoKeyframe
+
+Adds current position into the seek index and writes
+client state that isn't sent with every non-delta update
+but can be skipped while seeking: lightstyles and players info
+====================
+*/
+static void CL_WriteDemoKeyframe( file_t *file )
+{
+	static byte	data[MAX_LIGHTSTYLES * 64 + MAX_CLIENTS * ( MAX_INFO_STRING + 8 )];
+	demokeyframe_t	*key;
+	player_info_t	*player;
+	lightstyle_t	*ls;
+	sizebuf_t		buf;
+	int		i, offset, swlen;
+
+	if( demo.numkeyframes >= MAX_DEMO_KEYFRAMES )
+		return;
+
+	offset = FS_Tell( file );
+	MSG_Init( &buf, "DemoKeyframe", data, sizeof( data ));
+
+	for( i = 0, ls = cl.lightstyles; i < MAX_LIGHTSTYLES; i++, ls++ )
+	{
+		if( !ls->length ) continue;
+
+		MSG_BeginServerCmd( &buf, svc_lightstyle );
+		MSG_WriteByte( &buf, i );
+		MSG_WriteString( &buf, ls->pattern );
+		MSG_WriteFloat( &buf, ls->time );
+	}
+
+	for( i = 0, player = cl.players; i < cl.maxclients; i++, player++ )
+	{
+		MSG_BeginServerCmd( &buf, svc_updateuserinfo );
+		MSG_WriteUBitLong( &buf, i, MAX_CLIENT_BITS );
+		MSG_WriteLong( &buf, player->userid );
+
+		if( player->userinfo[0] )
+		{
+			MSG_WriteOneBit( &buf, 1 );
+			MSG_WriteString( &buf, player->userinfo );
+		}
+		else MSG_WriteOneBit( &buf, 0 );
+	}
+
+	if( MSG_CheckOverflow( &buf ))
+	{
+		MsgDev( D_WARN, "CL_WriteDemoKeyframe: client state is too big\n" );
+		return;
+	}
+
+	// it's parsed on playback as usual network message
+	CL_WriteDemoCmdHeader( dem_read, file );
+	CL_WriteDemoSequence( file );
+
+	swlen = MSG_GetNumBytesWritten( &buf );
+	FS_Write( file, &swlen, sizeof( int ));
+	FS_Write( file, data, swlen );
+
+	if( demo.numkeyframes >= demo.maxkeyframes )
+	{
+		demo.maxkeyframes += 64;
+		demo.keyframes = Mem_Realloc( cls.mempool, demo.keyframes, sizeof( demokeyframe_t ) * demo.maxkeyframes );
+	}
+
+	key = &demo.keyframes[demo.numkeyframes++];
+	key->time = demo.levelstart + demo.msgtime;
+	key->timestamp = demo.msgtime;
+	key->level = demo.level;
+	key->offset = offset;
+
+	demo.lastkeyframe = cls.demotime;
+}
+
 /*
 ====================
 CL_WriteDemoMessage
@@ -294,6 +464,22 @@ void CL_WriteDemoMessage( qboolean startup, int start, sizebuf_t *msg )
 	// demo playback should read this as an incoming message.
 	c = (cls.state != ca_active) ? dem_norewind : dem_read;
 
+	if( !startup && c == dem_read )
+	{
+		if( demo.keyframe )
+		{
+			CL_WriteDemoKeyframe( file );
+		}
+		else if( cl_demokeyframes->value > 0.0f && !cls.demokeyframe )
+		{
+			// ask the server for a non-delta update
+			if(( cls.demotime - demo.lastkeyframe ) >= cl_demokeyframes->value )
+				cls.demokeyframe = true;
+		}
+	}
+
+	demo.keyframe = false;
+
 	CL_WriteDemoCmdHeader( c, file );
 	CL_WriteDemoSequence( file );
 
@@ -404,6 +590,14 @@ void CL_WriteDemoHeader( const char *name )
 
 	demo.entry->offset = FS_Tell( cls.demofile );
 
+	// seek index starts from the first data lump
+	demo.levelstart = demo.msgtime = 0.0f;
+	demo.level = 0;
+	demo.lastkeyframe = 0.0;
+	demo.keyframe = false;
+	cls.demokeyframe = false;
+	CL_FreeDemoKeyframes();
+
 	// demo playback should read this as an incoming message.
 	// write the client's realtime value out so we can synchronize the reads.
 	CL_WriteDemoCmdHeader( dem_jumptime, cls.demofile );
@@ -448,8 +642,20 @@ void CL_StopRecord( void )
 	for( i = 0; i < demo.directory.numentries; i++ )
 		FS_Write( cls.demofile, &demo.directory.entries[i], sizeof( demoentry_t ));
 
+	// seek index goes after the directory so old versions will ignore it
+	if( demo.numkeyframes > 0 )
+	{
+		int	ident = IDEMOSEEK;
+
+		FS_Write( cls.demofile, &ident, sizeof( int ));
+		FS_Write( cls.demofile, &demo.numkeyframes, sizeof( int ));
+		FS_Write( cls.demofile, demo.keyframes, sizeof( demokeyframe_t ) * demo.numkeyframes );
+	}
+
 	Mem_Free( demo.directory.entries );
 	demo.directory.numentries = 0;
+	CL_FreeDemoKeyframes();
+	cls.demokeyframe = false;
 
 	demo.header.directory_offset = curpos;
 	FS_Seek( cls.demofile, 0, SEEK_SET );
@@ -658,6 +864,9 @@ qboolean CL_DemoMoveToNextSection( void )
 	demo.starttime = CL_GetDemoPlaybackClock();
 	demo.framecount = 0;
 
+	demo.levelstart = demo.msgtime = 0.0f;
+	demo.level = 0;
+
 	return true;
 }
 
@@ -703,6 +912,210 @@ qboolean CL_ReadRawNetworkData( byte *buffer, size_t *length )
 	return true;
 }
 
+/*
+=================
+CL_DemoTime
+
+playback time since start of the first level
+=================
+*/
+static float CL_DemoTime( void )
+{
+	return demo.levelstart + demo.msgtime;
+}
+
+/*
+=================
+CL_DemoFindKeyframe
+
+returns latest keyframe of current
+level before the specified time
+=================
+*/
+static demokeyframe_t *CL_DemoFindKeyframe( float time )
+{
+	demokeyframe_t	*key, *best = NULL;
+	int		i;
+
+	for( i = 0, key = demo.keyframes; i < demo.numkeyframes; i++, key++ )
+	{
+		if( key->level > demo.level )
+			break; // index is sorted
+
+		if( key->level == demo.level && key->time <= time )
+			best = key;
+	}
+
+	return best;
+}
+
+/*
+=================
+CL_DemoJumpToKeyframe
+
+keyframe is a full update so
+the rest of the level can be skipped
+=================
+*/
+static void CL_DemoJumpToKeyframe( demokeyframe_t *key )
+{
+	FS_Seek( cls.demofile, key->offset, SEEK_SET );
+
+	demo.msgtime = demo.timestamp = key->timestamp;
+	demo.starttime = CL_GetDemoPlaybackClock() - key->timestamp;
+
+	// angles and effects belong to other time
+	memset( demo.cmds, 0, sizeof( demo.cmds ));
+	demo.angle_position = 1;
+	demo.lasttime = 0.0f;
+
+	CL_ClearTempEnts();
+	CL_ClearParticles();
+	CL_ClearViewBeams();
+}
+
+/*
+=================
+CL_DemoSkipToKeyframe
+
+move forward through the current level
+with seek index while fast-forwarding
+=================
+*/
+static void CL_DemoSkipToKeyframe( void )
+{
+	demokeyframe_t	*key;
+
+	// wait for signon of new level
+	if( cls.state != ca_active || !demo.entryIndex )
+		return;
+
+	demo.seeklevel = demo.level;
+	key = CL_DemoFindKeyframe( demo.seektime );
+
+	if( key && key->time > CL_DemoTime( ))
+		CL_DemoJumpToKeyframe( key );
+}
+
+/*
+=================
+CL_DemoSeek
+
+jump to the nearest keyframe and parse the rest of messages
+without waiting, demo is restarted to go back without keyframe
+=================
+*/
+static void CL_DemoSeek( float time )
+{
+	demokeyframe_t	*key;
+	string		demoname;
+
+	time = Q_max( time, 0.0f );
+
+	if( time < CL_DemoTime( ))
+	{
+		key = CL_DemoFindKeyframe( time );
+
+		if( key && cls.state == ca_active && demo.entryIndex )
+		{
+			CL_DemoJumpToKeyframe( key );
+		}
+		else
+		{
+			Q_strncpy( demoname, cls.demoname, sizeof( demoname ));
+			Cmd_ExecuteString( va( "playdemo %s\n", demoname ));
+			if( !cls.demoplayback ) return;
+		}
+	}
+
+	demo.seeking = true;
+	demo.seektime = time;
+	CL_DemoSkipToKeyframe();
+}
+
+/*
+=================
+CL_DemoBenchParse
+
+called for each parsed svc while benchmarking
+=================
+*/
+void CL_DemoBenchParse( int cmd, int bytes, double time )
+{
+	demobench_t	*b = &bench.svc[cmd & 255];
+
+	b->count++;
+	b->bytes += bytes;
+	b->time += time;
+}
+
+/*
+=================
+CL_DemoBenchEmit
+=================
+*/
+void CL_DemoBenchEmit( double time )
+{
+	bench.emit.count++;
+	bench.emit.time += time;
+}
+
+/*
+=================
+CL_DemoBenchCompare
+=================
+*/
+static int CL_DemoBenchCompare( const void *a, const void *b )
+{
+	double	ta = bench.svc[*(const int *)a].time;
+	double	tb = bench.svc[*(const int *)b].time;
+
+	if( ta > tb ) return -1;
+	if( ta < tb ) return 1;
+	return 0;
+}
+
+/*
+=================
+CL_DemoBenchReport
+
+print messages throughput and
+time spent in each svc
+=================
+*/
+static void CL_DemoBenchReport( void )
+{
+	double		total = Sys_DoubleTime() - bench.starttime;
+	int		frames = host.framecount - bench.startframe;
+	int		i, numsvc, sorted[256];
+	double		parsetime = 0.0;
+	demobench_t	*b;
+
+	for( i = numsvc = 0; i < 256; i++ )
+	{
+		if( !bench.svc[i].count ) continue;
+		parsetime += bench.svc[i].time;
+		sorted[numsvc++] = i;
+	}
+
+	qsort( sorted, numsvc, sizeof( int ), CL_DemoBenchCompare );
+	total = Q_max( total, 0.001 );
+
+	Msg( "benchdemo %s: %i messages (%s) in %i frames, %.2f sec\n", cls.demoname, bench.messages, Q_memprint( bench.bytes ), frames, total );
+	Msg( "%.1f messages/sec, %.1f frames/sec, parse %.2f sec, entities %.2f sec\n", bench.messages / total, frames / total, parsetime, bench.emit.time );
+	Msg( "%-24s %8s %10s %10s %8s\n", "message", "count", "bytes", "msec", "usec" );
+	Msg( "---------------------------------------------------------------\n" );
+
+	for( i = 0; i < numsvc; i++ )
+	{
+		b = &bench.svc[sorted[i]];
+		Msg( "%-24s %8i %10s %10.2f %8.2f\n", CL_MsgInfo( sorted[i] ), b->count, Q_memprint( b->bytes ), b->time * 1000.0, b->time * 1000000.0 / b->count );
+	}
+
+	if( bench.emit.count )
+		Msg( "%-24s %8i %10s %10.2f %8.2f\n", "(link entities)", bench.emit.count, "", bench.emit.time * 1000.0, bench.emit.time * 1000000.0 / bench.emit.count );
+}
+
 /*
 =================
 CL_DemoReadMessage
@@ -729,7 +1142,17 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 	// HACKHACK: changedemo issues
 	if( !cls.netchan.remote_address.type ) cls.netchan.remote_address.type = NA_LOOPBACK;
 
-	if(( !cl.background && ( cl.paused || cls.key_dest != key_game )) || cls.key_dest == key_console )
+	if( demo.seeking || cls.demobench )
+	{
+		// new level was started while seeking
+		if( demo.seeking && demo.seeklevel != demo.level )
+			CL_DemoSkipToKeyframe();
+
+		// benchmark reads one message per frame so each of them is interpolated
+		if( cls.demobench && bench.lastframe == host.framecount )
+			return false;
+	}
+	else if(( !cl.background && ( cl.paused || cls.key_dest != key_game )) || cls.key_dest == key_console )
 	{
 		demo.starttime += host.frametime;
 		return false; // paused
@@ -746,6 +1169,7 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 
 		fElapsedTime = CL_GetDemoPlaybackClock() - demo.starttime;
 		bSkipMessage = ((demo.timestamp - cl_serverframetime()) >= fElapsedTime) ? true : false;
+		if( demo.seeking || cls.demobench ) bSkipMessage = false; // fast-forward
 		if( cls.changelevel ) demo.framecount = 1;
 
 		// changelevel issues
@@ -765,12 +1189,20 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 
 		// we already have the usercmd_t for this frame
 		// don't read next usercmd_t so predicting will work properly
-		if( cmd == dem_usercmd && lastpos != 0 && demo.framecount != 0 )
+		if( cmd == dem_usercmd && lastpos != 0 && demo.framecount != 0 && !demo.seeking && !cls.demobench )
 		{
 			FS_Seek( cls.demofile, lastpos, SEEK_SET );
 			return false; // not time yet.
 		}
 
+		// message is consumed, update demo time
+		if( cmd == dem_jumptime )
+		{
+			demo.levelstart += demo.msgtime;
+			demo.level++;
+		}
+		demo.msgtime = demo.timestamp;
+
 		// COMMAND HANDLERS
 		switch( cmd )
 		{
@@ -815,10 +1247,27 @@ qboolean CL_DemoReadMessage( byte *buffer, size_t *length )
 		}	
 	}
 
+	if( demo.seeking && demo.entryIndex && CL_DemoTime() >= demo.seektime )
+	{
+		// continue normal playback from this message
+		demo.starttime = CL_GetDemoPlaybackClock() - demo.timestamp;
+		demo.seeking = false;
+	}
+
 	demo.framecount++;
 	CL_ReadDemoSequence( false );
 
-	return CL_ReadRawNetworkData( buffer, length );
+	if( !CL_ReadRawNetworkData( buffer, length ))
+		return false;
+
+	if( cls.demobench )
+	{
+		bench.lastframe = host.framecount;
+		bench.bytes += *length;
+		bench.messages++;
+	}
+
+	return true;
 }
 
 void CL_DemoFindInterpolatedViewAngles( float t, float *frac, demoangle_t **prev, demoangle_t **next )
@@ -905,6 +1354,15 @@ void CL_StopPlayback( void )
 {
 	if( !cls.demoplayback ) return;
 
+	if( cls.demobench )
+	{
+		CL_DemoBenchReport();
+		cls.demobench = false;
+
+		if( bench.quit )
+			Cbuf_AddText( "quit\n" );
+	}
+
 	// release demofile
 	FS_Close( cls.demofile );
 	cls.demoplayback = false;
@@ -917,6 +1375,8 @@ void CL_StopPlayback( void )
 	demo.directory.entries = NULL;
 	demo.header.host_fps = 0.0;
 	demo.entry = NULL;
+	demo.seeking = false;
+	CL_FreeDemoKeyframes();
 
 	cls.demoname[0] = '\0';	// clear demoname too
 	gameui.globals->demoname[0] = '\0';
@@ -1150,6 +1610,45 @@ void CL_Record_f( void )
 	CL_WriteDemoHeader( demopath );
 }
 
+/*
+====================
+CL_ReadDemoKeyframes
+
+read seek index from the end of demo,
+demos without index are seeked by parsing
+====================
+*/
+static void CL_ReadDemoKeyframes( void )
+{
+	int	ident = 0, count = 0;
+	size_t	size;
+
+	CL_FreeDemoKeyframes();
+
+	if( FS_Read( cls.demofile, &ident, sizeof( int )) != sizeof( int ) || ident != IDEMOSEEK )
+		return;
+
+	FS_Read( cls.demofile, &count, sizeof( int ));
+
+	if( count <= 0 || count > MAX_DEMO_KEYFRAMES )
+	{
+		MsgDev( D_WARN, "demo had bogus # of keyframes: %i\n", count );
+		return;
+	}
+
+	size = sizeof( demokeyframe_t ) * count;
+	demo.keyframes = Mem_Alloc( cls.mempool, size );
+
+	if( FS_Read( cls.demofile, demo.keyframes, size ) != size )
+	{
+		MsgDev( D_WARN, "demo seek index is truncated\n" );
+		CL_FreeDemoKeyframes();
+		return;
+	}
+
+	demo.numkeyframes = demo.maxkeyframes = count;
+}
+
 /*
 ====================
 CL_PlayDemo_f
@@ -1253,6 +1752,8 @@ void CL_PlayDemo_f( void )
 		FS_Read( cls.demofile, &demo.directory.entries[i], sizeof( demoentry_t ));
 	}
 
+	CL_ReadDemoKeyframes();
+
 	demo.entryIndex = 0;
 	demo.entry = &demo.directory.entries[demo.entryIndex];
 
@@ -1271,6 +1772,9 @@ void CL_PlayDemo_f( void )
 	memset( demo.cmds, 0, sizeof( demo.cmds ));
 	demo.angle_position = 1;
 	demo.framecount = 0;
+	demo.levelstart = demo.msgtime = 0.0f;
+	demo.level = demo.seeklevel = 0;
+	demo.seeking = false;
 	cls.lastoutgoingcommand = -1;
  	cls.nextcmdtime = host.realtime;
 	cl.last_command_ack = -1;
@@ -1281,6 +1785,93 @@ void CL_PlayDemo_f( void )
 	// begin a playback demo
 }
 
+/*
+====================
+CL_DemoSeek_f
+
+demo_seek <seconds>
+====================
+*/
+void CL_DemoSeek_f( void )
+{
+	if( Cmd_Argc() != 2 )
+	{
+		Msg( "Usage: demo_seek <seconds>\n" );
+		if( cls.demoplayback ) Msg( "current time %.1f sec, %i keyframes\n", CL_DemoTime(), demo.numkeyframes );
+		return;
+	}
+
+	if( !cls.demoplayback )
+	{
+		Msg( "No demo is playing.\n" );
+		return;
+	}
+
+	CL_DemoSeek( Q_atof( Cmd_Argv( 1 )));
+}
+
+/*
+====================
+CL_DemoForward_f
+
+demo_forward <seconds>
+====================
+*/
+void CL_DemoForward_f( void )
+{
+	float	time;
+
+	if( Cmd_Argc() != 2 )
+	{
+		Msg( "Usage: demo_forward <seconds>\n" );
+		return;
+	}
+
+	if( !cls.demoplayback )
+	{
+		Msg( "No demo is playing.\n" );
+		return;
+	}
+
+	// continue from the target of current seek
+	time = demo.seeking ? demo.seektime : CL_DemoTime();
+	CL_DemoSeek( time + Q_atof( Cmd_Argv( 1 )));
+}
+
+/*
+====================
+CL_BenchDemo_f
+
+benchdemo <demoname> [quit]
+====================
+*/
+void CL_BenchDemo_f( void )
+{
+	qboolean	quit;
+
+	if( Cmd_Argc() < 2 || Cmd_Argc() > 3 )
+	{
+		Msg( "Usage: benchdemo <demoname> [quit]\n" );
+		return;
+	}
+
+	quit = ( Cmd_Argc() == 3 && !Q_stricmp( Cmd_Argv( 2 ), "quit" ));
+	Cmd_ExecuteString( va( "playdemo %s\n", Cmd_Argv( 1 )));
+
+	if( !cls.demoplayback )
+	{
+		if( quit ) Cbuf_AddText( "quit\n" );
+		return;
+	}
+
+	memset( &bench, 0, sizeof( bench ));
+	bench.starttime = Sys_DoubleTime();
+	bench.startframe = host.framecount;
+	bench.lastframe = -1;
+	bench.quit = quit;
+	cls.demobench = true;
+}
+
 /*
 ==================
 CL_StartDemos_f
@@ -755,6 +755,7 @@ int CL_ParsePacketEntities( sizebuf_t *msg, qboolean delta )
 		oldpacket = -1;		// delta too old or is initial message
 		cl.send_reply = true;	// send reply
 		cls.demowaiting = false;	// we can start recording now
+		CL_DemoMarkKeyframe();	// demo can be seeked to this message
 	}
 
 	// mark current delta state
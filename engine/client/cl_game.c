@@ -1046,6 +1046,45 @@ void CL_DrawHUD( int state )
 	}
 }
 
+/*
+=============
+CL_SetUserMessageName
+
+resolve engine handled messages once
+=============
+*/
+static void CL_SetUserMessageName( cl_user_message_t *msg, const char *pszName )
+{
+	Q_strncpy( msg->name, pszName, sizeof( msg->name ));
+	msg->flags = 0;
+
+	if( !Q_strcmp( msg->name, "ScreenShake" ))
+		SetBits( msg->flags, UMSG_SCREENSHAKE );
+	else if( !Q_strcmp( msg->name, "ScreenFade" ))
+		SetBits( msg->flags, UMSG_SCREENFADE );
+	else if( !Q_stricmp( msg->name, "HudText" ))
+		SetBits( msg->flags, UMSG_HUDTEXT );
+}
+
+/*
+=============
+CL_SetUserMessageNumber
+
+update svc_ number to message lookup table
+=============
+*/
+static void CL_SetUserMessageNumber( int i, int svc_num )
+{
+	cl_user_message_t	*msg = &clgame.msg[i];
+
+	// unlink previous number
+	if( clgame.msg_index[msg->number & 255] == i + 1 )
+		clgame.msg_index[msg->number & 255] = 0;
+
+	msg->number = svc_num;
+	clgame.msg_index[svc_num & 255] = i + 1;
+}
+
 void CL_LinkUserMessage( char *pszName, const int svc_num, int iSize )
 {
 	int	i;
@@ -1062,7 +1101,7 @@ void CL_LinkUserMessage( char *pszName, const int svc_num, int iSize )
 		// NOTE: no check for DispatchFunc, check only name
 		if( !Q_strcmp( clgame.msg[i].name, pszName ))
 		{
-			clgame.msg[i].number = svc_num;
+			CL_SetUserMessageNumber( i, svc_num );
 			clgame.msg[i].size = iSize;
 			return;
 		}
@@ -1075,8 +1114,8 @@ void CL_LinkUserMessage( char *pszName, const int svc_num, int iSize )
 	}
 
 	// register new message without DispatchFunc, so we should parse it properly
-	Q_strncpy( clgame.msg[i].name, pszName, sizeof( clgame.msg[i].name ));
-	clgame.msg[i].number = svc_num;
+	CL_SetUserMessageName( &clgame.msg[i], pszName );
+	CL_SetUserMessageNumber( i, svc_num );
 	clgame.msg[i].size = iSize;
 }
 
@@ -1626,7 +1665,7 @@ static int pfnHookUserMsg( const char *pszName, pfnUserMsgHook pfn )
 	}
 
 	// hook new message
-	Q_strncpy( clgame.msg[i].name, pszName, sizeof( clgame.msg[i].name ));
+	CL_SetUserMessageName( &clgame.msg[i], pszName );
 	clgame.msg[i].func = pfn;
 
 	return 1;
@@ -182,7 +182,9 @@ static void UI_DrawLogo( const char *filename, float x, float y, float width, fl
 
 	if( cin_frame != last_frame )
 	{
+		S_LockSoundTrack();
 		cin_data = AVI_GetVideoFrame( cin_state, cin_frame );
+		S_UnlockSoundTrack();
 		last_frame = cin_frame;
 		redraw = true;
 	}
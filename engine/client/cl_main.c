@@ -34,9 +34,11 @@ convar_t	*cl_timeout;
 convar_t	*cl_nopred;
 convar_t	*cl_showfps;
 convar_t	*cl_nodelta;
+convar_t	*cl_demokeyframes;
 convar_t	*cl_crosshair;
 convar_t	*cl_cmdbackup;
 convar_t	*cl_showerror;
+convar_t	*cl_fastpredict;
 convar_t	*cl_bmodelinterp;
 convar_t	*cl_draw_particles;
 convar_t	*cl_draw_tracers;
@@ -808,7 +810,7 @@ void CL_WritePacket( void )
 		i = cls.netchan.outgoing_sequence & CL_UPDATE_MASK;
 	
 		// determine if we need to ask for a new set of delta's.
-		if( cl.validsequence && (cls.state == ca_active) && !( cls.demorecording && cls.demowaiting ))
+		if( cl.validsequence && (cls.state == ca_active) && !( cls.demorecording && ( cls.demowaiting || cls.demokeyframe )))
 		{
 			cl.delta_sequence = cl.validsequence;
 
@@ -923,7 +925,8 @@ void CL_SendConnectPacket( void )
 	if( adr.port == 0 ) adr.port = MSG_BigShort( PORT_SERVER );
 	port = Cvar_VariableValue( "net_qport" );
 
-	Netchan_OutOfBandPrint( NS_CLIENT, adr, "connect %i %i %i \"%s\"\n", PROTOCOL_VERSION, port, cls.challenge, cls.userinfo );
+	// last argument tells server that we can decompress fragments
+	Netchan_OutOfBandPrint( NS_CLIENT, adr, "connect %i %i %i \"%s\" lzss\n", PROTOCOL_VERSION, port, cls.challenge, cls.userinfo );
 }
 
 /*
@@ -1690,6 +1693,7 @@ void CL_ConnectionlessPacket( netadr_t from, sizebuf_t *msg )
 		}
 
 		Netchan_Setup( NS_CLIENT, &cls.netchan, from, Cvar_VariableValue( "net_qport" ), NULL, NULL );
+		cls.netchan.compress = !Q_stricmp( Cmd_Argv( 1 ), "lzss" ); // old servers doesn't send it
 		MSG_BeginClientCmd( &cls.netchan.message, clc_stringcmd );
 		MSG_WriteString( &cls.netchan.message, "new" );
 		cls.state = ca_connected;
@@ -1889,7 +1893,11 @@ void CL_ReadNetMessage( void )
 		}
 
 		if( !cls.demoplayback && !Netchan_Process( &cls.netchan, &net_message ))
+		{
+			if( cls.netchan.bad_fragments >= NET_MAX_BAD_FRAGMENTS )
+				Host_Error( "CL_ReadPackets: server sent malformed compressed data\n" );
 			continue;	// wasn't accepted for some reason
+		}
 
 		CL_ParseServerMessage( &net_message, true );
 		cl.send_reply = true;
@@ -2192,6 +2200,7 @@ void CL_InitLocal( void )
 	// register our variables
 	cl_crosshair = Cvar_Get( "crosshair", "1", FCVAR_ARCHIVE, "show weapon chrosshair" );
 	cl_nodelta = Cvar_Get ("cl_nodelta", "0", 0, "disable delta-compression for server messages" );
+	cl_demokeyframes = Cvar_Get( "cl_demokeyframes", "30", FCVAR_ARCHIVE, "interval in seconds between seekable full updates in recorded demos, 0 is disable" );
 	cl_idealpitchscale = Cvar_Get( "cl_idealpitchscale", "0.8", 0, "how much to look up/down slopes and stairs when not using freelook" );
 	cl_solid_players = Cvar_Get( "cl_solid_players", "1", 0, "Make all players not solid (can't traceline them)" );
 	cl_interp = Cvar_Get( "ex_interp", "0.1", FCVAR_ARCHIVE, "Interpolate object positions starting this many seconds in past" ); 
@@ -2225,6 +2234,7 @@ void CL_InitLocal( void )
 	cl_draw_beams = Cvar_Get( "r_drawbeams", "1", FCVAR_CHEAT|FCVAR_ARCHIVE, "render beams" );
 	cl_lightstyle_lerping = Cvar_Get( "cl_lightstyle_lerping", "0", FCVAR_ARCHIVE, "enables animated light lerping (perfomance option)" );
 	cl_showerror = Cvar_Get( "cl_showerror", "0", FCVAR_ARCHIVE, "show prediction error" );
+	cl_fastpredict = Cvar_Get( "cl_fastpredict", "1", FCVAR_ARCHIVE, "don't repeat prediction of commands when server confirms predicted state" );
 	cl_bmodelinterp = Cvar_Get( "cl_bmodelinterp", "1", FCVAR_ARCHIVE, "enable bmodel interpolation" );
 	cl_clockreset = Cvar_Get( "cl_clockreset", "0.1", FCVAR_ARCHIVE, "frametime delta maximum value before reset" );
 	cl_fixtimerate = Cvar_Get( "cl_fixtimerate", "7.5", FCVAR_ARCHIVE, "time in msec to client clock adjusting" );
@@ -2259,6 +2269,9 @@ void CL_InitLocal( void )
 	Cmd_AddCommand ("disconnect", CL_Disconnect_f, "disconnect from server" );
 	Cmd_AddCommand ("record", CL_Record_f, "record a demo" );
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f, "play a demo" );
+	Cmd_AddCommand ("demo_seek", CL_DemoSeek_f, "jump to specified time in seconds of playing demo" );
+	Cmd_AddCommand ("demo_forward", CL_DemoForward_f, "fast-forward playing demo by specified amount of seconds" );
+	Cmd_AddCommand ("benchdemo", CL_BenchDemo_f, "measure demo parsing speed without drawing, optionally quit when done" );
 	Cmd_AddCommand ("killdemo", CL_DeleteDemo_f, "delete a specified demo file and demoshot" );
 	Cmd_AddCommand ("startdemos", CL_StartDemos_f, "start playing back the selected demos sequentially" );
 	Cmd_AddCommand ("demos", CL_Demos_f, "restart looping demos defined by the last startdemos command" );
@@ -2365,6 +2378,8 @@ Host_ClientFrame
 */
 void Host_ClientFrame( void )
 {
+	double	emittime = 0.0;
+
 	// if client is not active, do nothing
 	if( !cls.initialized ) return;
 
@@ -2387,7 +2402,9 @@ void Host_ClientFrame( void )
 //	Voice_Idle( host.frametime );
 
 	// emit visible entities
+	if( cls.demobench ) emittime = Sys_DoubleTime();
 	CL_EmitEntities ();
+	if( cls.demobench ) CL_DemoBenchEmit( Sys_DoubleTime() - emittime );
 
 	// in case we lost connection
 	CL_CheckForResend ();
@@ -2406,10 +2423,10 @@ void Host_ClientFrame( void )
 	VGui_RunFrame ();
 
 	// update the screen
-	SCR_UpdateScreen ();
+	if( !cls.demobench ) SCR_UpdateScreen ();
 
 	// update audio
-	SND_UpdateSound ();
+	if( !cls.demobench ) SND_UpdateSound ();
 
 	// animate lightestyles
 	CL_RunLightStyles ();
@@ -121,16 +121,9 @@ const char *CL_MsgInfo( int cmd )
 	}
 	else if( cmd > svc_lastmsg && cmd <= ( svc_lastmsg + MAX_USER_MESSAGES ))
 	{
-		int	i;
+		int	i = clgame.msg_index[cmd & 255];
 
-		for( i = 0; i < MAX_USER_MESSAGES; i++ )
-		{
-			if( clgame.msg[i].number == cmd )
-			{
-				Q_strncpy( sz, clgame.msg[i].name, sizeof( sz ));
-				break;
-			}
-		}
+		if( i ) Q_strncpy( sz, clgame.msg[i - 1].name, sizeof( sz ));
 	}
 	return sz;
 }
@@ -1567,8 +1560,9 @@ handles all user messages
 */
 void CL_ParseUserMessage( sizebuf_t *msg, int svc_num )
 {
-	int	i, iSize;
-	byte	pbuf[256]; // message can't be larger than 255 bytes
+	cl_user_message_t	*umsg;
+	byte		pbuf[256]; // message can't be larger than 255 bytes
+	int		i, iSize;
 
 	// NOTE: any user message is really parse at engine, not in client.dll
 	if( svc_num <= svc_lastmsg || svc_num > ( MAX_USER_MESSAGES + svc_lastmsg ))
@@ -1578,29 +1572,30 @@ void CL_ParseUserMessage( sizebuf_t *msg, int svc_num )
 		return;
 	}
 
-	for( i = 0; i < MAX_USER_MESSAGES; i++ )
+	// search for user message
+	i = clgame.msg_index[svc_num & 255];
+
+	if( !i ) // probably unregistered
 	{
-		// search for user message
-		if( clgame.msg[i].number == svc_num )
-			break;
+		Host_Error( "CL_ParseUserMessage: illegible server message %d\n", svc_num );
+		return;
 	}
 
-	if( i == MAX_USER_MESSAGES ) // probably unregistered
-		Host_Error( "CL_ParseUserMessage: illegible server message %d\n", svc_num );
+	umsg = &clgame.msg[i - 1];
 
 	// NOTE: some user messages handled into engine
-	if( !Q_strcmp( clgame.msg[i].name, "ScreenShake" ))
+	if( FBitSet( umsg->flags, UMSG_SCREENSHAKE ))
 	{
 		CL_ParseScreenShake( msg );
 		return;
 	}
-	else if( !Q_strcmp( clgame.msg[i].name, "ScreenFade" ))
+	else if( FBitSet( umsg->flags, UMSG_SCREENFADE ))
 	{
 		CL_ParseScreenFade( msg );
 		return;
 	}
 
-	iSize = clgame.msg[i].size;
+	iSize = umsg->size;
 
 	// message with variable sizes receive an actual size as first byte
 	if( iSize == -1 ) iSize = MSG_ReadByte( msg );
@@ -1608,13 +1603,13 @@ void CL_ParseUserMessage( sizebuf_t *msg, int svc_num )
 	// parse user message into buffer
 	MSG_ReadBytes( msg, pbuf, iSize );
 
-	if( clgame.msg[i].func )
+	if( umsg->func )
 	{
-		clgame.msg[i].func( clgame.msg[i].name, iSize, pbuf );
+		umsg->func( umsg->name, iSize, pbuf );
 
 		// HACKHACK: run final credits for Half-Life
 		// because hl1 doesn't have call END_SECTION
-		if( !Q_stricmp( clgame.msg[i].name, "HudText" ) && !Q_stricmp( GI->gamefolder, "valve" ))
+		if( FBitSet( umsg->flags, UMSG_HUDTEXT ) && !Q_stricmp( GI->gamefolder, "valve" ))
 		{
 			// it's a end, so we should run credits
 			if( !Q_strcmp( (char *)pbuf, "END3" ))
@@ -1623,8 +1618,8 @@ void CL_ParseUserMessage( sizebuf_t *msg, int svc_num )
 	}
 	else
 	{
-		MsgDev( D_ERROR, "CL_ParseUserMessage: %s not hooked\n", clgame.msg[i].name );
-		clgame.msg[i].func = CL_UserMsgStub; // throw warning only once
+		MsgDev( D_ERROR, "CL_ParseUserMessage: %s not hooked\n", umsg->name );
+		umsg->func = CL_UserMsgStub; // throw warning only once
 	}
 }
 
@@ -1660,6 +1655,7 @@ void CL_ParseServerMessage( sizebuf_t *msg, qboolean normal_message )
 	char	*s;
 	int	i, cmd, param1, param2;
 	size_t	bufStart, playerbytes;
+	double	parsetime = 0.0;
 
 	cls_message_debug.parsing = true;		// begin parsing
 	starting_count = MSG_GetNumBytesRead( msg );	// updates each frame
@@ -1699,6 +1695,8 @@ void CL_ParseServerMessage( sizebuf_t *msg, qboolean normal_message )
 		// record command for debugging spew on parse problem
 		CL_Parse_RecordCommand( cmd, bufStart );
 
+		if( cls.demobench ) parsetime = Sys_DoubleTime();
+
 		// other commands
 		switch( cmd )
 		{
@@ -1906,6 +1904,9 @@ void CL_ParseServerMessage( sizebuf_t *msg, qboolean normal_message )
 			cl.frames[cl.parsecountmod].graphdata.usr += MSG_GetNumBytesRead( msg ) - bufStart;
 			break;
 		}
+
+		if( cls.demobench )
+			CL_DemoBenchParse( cmd, MSG_GetNumBytesRead( msg ) - bufStart, Sys_DoubleTime() - parsetime );
 	}
 
 	cl.frames[cl.parsecountmod].graphdata.msgbytes += MSG_GetNumBytesRead( msg ) - starting_count;
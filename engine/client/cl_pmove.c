@@ -25,6 +25,8 @@ GNU General Public License for more details.
 #define MIN_CORRECTION_DISTANCE	0.25f	// use smoothing if error is > this
 #define MIN_PREDICTION_EPSILON	0.5f	// complain if error is > this and we have cl_showerror set
 #define MAX_PREDICTION_ERROR		64.0f	// above this is assumed to be a teleport, don't smooth, etc.
+#define MAX_PREDICTION_DELTA		0.125f	// server state is the same as predicted if difference is below this
+#define MAX_PREDICTION_TIME_DELTA	0.001f	// timers are sent with millisecond precision
 
 /*
 =============
@@ -1198,6 +1200,101 @@ void CL_MoveSpectatorCamera( void )
 	VectorCopy( cls.spectator_state.client.view_ofs, cl.viewheight );
 }
 
+/*
+=================
+CL_PredictedStateMatches
+
+check what server returned for acknowledged
+command with what we had predicted it to be
+=================
+*/
+static qboolean CL_PredictedStateMatches( const local_state_t *predicted, const local_state_t *server )
+{
+	const weapon_data_t	*pwd, *swd;
+	int		i;
+
+	if( predicted->client.flags != server->client.flags )
+		return false;
+
+	if( predicted->playerstate.usehull != server->playerstate.usehull )
+		return false;
+
+	if( predicted->client.waterlevel != server->client.waterlevel )
+		return false;
+
+	// duck transition and footstep timers are carried into next command
+	if( predicted->client.bInDuck != server->client.bInDuck )
+		return false;
+
+	if( predicted->client.flDuckTime != server->client.flDuckTime )
+		return false;
+
+	if( predicted->client.flTimeStepSound != server->client.flTimeStepSound )
+		return false;
+
+	if( fabs( predicted->client.m_flNextAttack - server->client.m_flNextAttack ) > MAX_PREDICTION_TIME_DELTA )
+		return false;
+
+	for( i = 0; i < 3; i++ )
+	{
+		if( fabs( predicted->playerstate.origin[i] - server->playerstate.origin[i] ) > MAX_PREDICTION_DELTA )
+			return false;
+
+		if( fabs( predicted->client.velocity[i] - server->client.velocity[i] ) > MAX_PREDICTION_DELTA )
+			return false;
+	}
+
+	for( i = 0, pwd = predicted->weapondata, swd = server->weapondata; i < MAX_LOCAL_WEAPONS; i++, pwd++, swd++ )
+	{
+		if( pwd->m_iId != swd->m_iId || pwd->m_iClip != swd->m_iClip || pwd->m_fInReload != swd->m_fInReload )
+			return false;
+
+		if( pwd->m_fInSpecialReload != swd->m_fInSpecialReload )
+			return false;
+
+		if( fabs( pwd->m_flNextPrimaryAttack - swd->m_flNextPrimaryAttack ) > MAX_PREDICTION_TIME_DELTA )
+			return false;
+
+		if( fabs( pwd->m_flNextSecondaryAttack - swd->m_flNextSecondaryAttack ) > MAX_PREDICTION_TIME_DELTA )
+			return false;
+
+		if( fabs( pwd->m_flTimeWeaponIdle - swd->m_flTimeWeaponIdle ) > MAX_PREDICTION_TIME_DELTA )
+			return false;
+
+		if( fabs( pwd->m_flNextReload - swd->m_flNextReload ) > MAX_PREDICTION_TIME_DELTA )
+			return false;
+	}
+
+	return true;
+}
+
+/*
+=================
+CL_LastReusableCommand
+
+returns last command which cached predicted state
+is still valid for the latest server frame or
+acknowledged command if all of them should be run again
+=================
+*/
+static int CL_LastReusableCommand( const local_state_t *from )
+{
+	int		ack = cls.netchan.incoming_acknowledged;
+	predicted_cmd_t	*base = &cl.predicted_cmds[ack & CL_UPDATE_MASK];
+
+	if( !cl_fastpredict->value || cls.demoplayback )
+		return ack;
+
+	// cached states are too old
+	if( ack < cl.local.predicted_base || ack > cl.local.predicted_last )
+		return ack;
+
+	if( base->sequence != ack || !CL_PredictedStateMatches( &base->state, from ))
+		return ack;
+
+	return cl.local.predicted_last;
+}
+
 /*
 =================
 CL_PredictMovement
@@ -1213,8 +1310,10 @@ void CL_PredictMovement( qboolean repredicting )
 	int		current_command_mod;
 	frame_t		*frame = NULL;
 	int		i, stoppoint;
+	int		reuse, last;
+	predicted_cmd_t	*cached;
 	qboolean		runfuncs;
-	double		time;
+	double		time, start;
 	float		f;
 
 	if( cls.state != ca_active || cls.spectator )
@@ -1260,6 +1359,25 @@ void CL_PredictMovement( qboolean repredicting )
 	cl.local.repredicting = repredicting;
 	cl.local.onground = -1;
 
+	// commands up to this one was already predicted from the state
+	// the server has confirmed, so they will give the same results
+	reuse = CL_LastReusableCommand( from );
+
+	// server state is the new base for cached commands
+	last = cls.netchan.incoming_acknowledged;
+	cached = &cl.predicted_cmds[last & CL_UPDATE_MASK];
+	cached->sequence = last;
+	cached->frametime = 0.0;
+	cached->lastground = cl.local.lastground;
+	cached->state = *from;
+
+	if( cl.local.predicted_framecount != host.framecount )
+	{
+		cl.local.predicted_framecount = host.framecount;
+		cl.local.predicted_simulated = 0;
+		cl.local.predicted_reused = 0;
+	}
+
 	// predict forward until cl.time <= to->senttime
 	CL_PushPMStates();
 	CL_SetSolidPlayers( cl.playernum );
@@ -1272,8 +1390,34 @@ void CL_PredictMovement( qboolean repredicting )
 		to = &cl.predicted_frames[(cl.parsecountmod + i) & CL_UPDATE_MASK];
 		to_cmd = &cl.commands[current_command_mod];
 		runfuncs = ( !repredicting && !to_cmd->processedfuncs );
+		cached = &cl.predicted_cmds[current_command_mod];
+
+		if( current_command <= reuse && cached->sequence == current_command )
+		{
+			*to = cached->state;
+			time += cached->frametime;
+			cl.local.lastground = cached->lastground;
+			cl.local.predicted_reused++;
+			last = current_command;
+		}
+		else
+		{
+			start = time;
+			CL_RunUsercmd( from, to, &to_cmd->cmd, runfuncs, &time, current_command );
+			cl.local.predicted_simulated++;
+			reuse = 0; // the rest of chain is based on the new state
+
+			// command that is not sent yet may be changed at the next frame
+			if( current_command < cls.netchan.outgoing_sequence )
+			{
+				cached->sequence = current_command;
+				cached->frametime = time - start;
+				cached->lastground = cl.local.lastground;
+				cached->state = *to;
+				last = current_command;
+			}
+		}
 
-		CL_RunUsercmd( from, to, &to_cmd->cmd, runfuncs, &time, current_command );
 		VectorCopy( to->playerstate.origin, cl.local.predicted_origins[current_command_mod] );
 		to_cmd->processedfuncs = true;
 
@@ -1285,6 +1429,12 @@ void CL_PredictMovement( qboolean repredicting )
 
 	CL_PopPMStates();
 
+	cl.local.predicted_base = cls.netchan.incoming_acknowledged;
+	cl.local.predicted_last = last;
+
+	if( cl_showerror->value > 1.0f && host.developer >= D_ERROR )
+		Con_NPrintf( 9, "prediction: %i commands simulated, %i reused\n", cl.local.predicted_simulated, cl.local.predicted_reused );
+
 	if(( i == CL_UPDATE_MASK ) || ( !to && !repredicting ))
 	{
 		cl.local.repredicting = false;
@@ -143,10 +143,10 @@ void SCR_RunCinematic( void )
 	if( UI_IsVisible( ))
 	{
 		// these can happens when user set +menu_ option to cmdline
+		S_StopStreaming();
 		AVI_CloseVideo( cin_state );
 		cls.state = ca_disconnected;
 		Key_SetKeyDest( key_menu );
-		S_StopStreaming();
 		cls.movienum = -1;
 		cin_time = 0.0f;
 		cls.signon = 0;
@@ -186,7 +186,9 @@ qboolean SCR_DrawCinematic( void )
 
 	if( cin_frame != last_frame )
 	{
+		S_LockSoundTrack();
 		frame = AVI_GetVideoFrame( cin_state, cin_frame );
+		S_UnlockSoundTrack();
 		last_frame = cin_frame;
 		redraw = true;
 	}
@@ -214,6 +216,9 @@ qboolean SCR_PlayCinematic( const char *arg )
 		return false;
 	}
 
+	// stop decoding of previous soundtrack
+	S_StopStreaming();
+
 	AVI_OpenVideo( cin_state, fullpath, true, false );
 	if( !AVI_IsActive( cin_state ))
 	{
@@ -269,8 +274,8 @@ void SCR_StopCinematic( void )
 	if( cls.state != ca_cinematic )
 		return;
 
-	AVI_CloseVideo( cin_state );
 	S_StopStreaming();
+	AVI_CloseVideo( cin_state );
 	cin_time = 0.0f;
 
 	cls.state = ca_disconnected;
@@ -304,6 +309,7 @@ void SCR_FreeCinematic( void )
 	AVI_CloseVideo( cin_state );
 
 	cin_state = AVI_GetState( CIN_MAIN );
+	S_StopStreaming();
 	AVI_CloseVideo( cin_state );
 
 	AVI_Shutdown();
@@ -99,6 +99,16 @@ typedef struct runcmd_s
 	int		sendsize;
 } runcmd_t;
 
+// predicted state after each sent command, used to skip
+// prediction of the commands when server agrees with it
+typedef struct
+{
+	int		sequence;		// command number
+	double		frametime;	// how much prediction time the command took
+	int		lastground;
+	local_state_t	state;
+} predicted_cmd_t;
+
 // add angles
 typedef struct
 {
@@ -132,6 +142,13 @@ typedef struct
 	vec3_t		lastorigin;
 	int		lastground;
 
+	// incremental prediction
+	int		predicted_base;	// acknowledged command the cached states are based on
+	int		predicted_last;	// last command which have cached state
+	int		predicted_framecount;
+	int		predicted_simulated;	// commands that was run through pmove this frame
+	int		predicted_reused;	// commands that was taken from cache this frame
+
 	// interp info
 	float		interp_amount;
 
@@ -198,6 +215,7 @@ typedef struct
 	frame_t		frames[MULTIPLAYER_BACKUP];		// alloced on svc_serverdata
 	runcmd_t		commands[MULTIPLAYER_BACKUP];		// each mesage will send several old cmds
 	local_state_t	predicted_frames[MULTIPLAYER_BACKUP];	// local client state
+	predicted_cmd_t	predicted_cmds[MULTIPLAYER_BACKUP];	// local client state after each command
 
 	double		time;			// this is the time value that the client
 						// is rendering at.  always <= cls.realtime
@@ -290,11 +308,17 @@ typedef enum
 	CL_CHANGELEVEL,	// draw 'loading' during changelevel
 } scrstate_t;
 
+// user messages that partially handled by engine
+#define UMSG_SCREENSHAKE	BIT( 0 )
+#define UMSG_SCREENFADE	BIT( 1 )
+#define UMSG_HUDTEXT	BIT( 2 )
+
 typedef struct
 {
 	char		name[32];
 	int		number;	// svc_ number
 	int		size;	// if size == -1, size come from first byte after svcnum
+	int		flags;	// UMSG_ flags resolved from name
 	pfnUserMsgHook	func;	// user-defined function	
 } cl_user_message_t;
 
@@ -451,6 +475,7 @@ typedef struct
 	int		oldphyscount;		// used by PM_Push\Pop state
 
 	cl_user_message_t	msg[MAX_USER_MESSAGES];	// keep static to avoid fragment memory
+	byte		msg_index[256];		// svc_ number to msg index + 1, 0 if not linked
 	cl_user_event_t	*events[MAX_EVENTS];
 
 	string		cdtracks[MAX_CDTRACKS];	// 32 cd-tracks read from cdaudio.txt
@@ -589,7 +614,9 @@ typedef struct
 	qboolean		demorecording;
 	qboolean		demoplayback;
 	qboolean		demowaiting;		// don't record until a non-delta message is received
+	qboolean		demokeyframe;		// request a non-delta message for demo seek index
 	qboolean		timedemo;
+	qboolean		demobench;		// parse demo as fast as possible without drawing
 	string		demoname;			// for demo looping
 	double		demotime;			// recording time
 
@@ -619,8 +646,10 @@ extern convar_t	*cl_showfps;
 extern convar_t	*cl_envshot_size;
 extern convar_t	*cl_timeout;
 extern convar_t	*cl_nodelta;
+extern convar_t	*cl_demokeyframes;
 extern convar_t	*cl_interp;
 extern convar_t	*cl_showerror;
+extern convar_t	*cl_fastpredict;
 extern convar_t	*cl_nosmooth;
 extern convar_t	*cl_smoothtime;
 extern convar_t	*cl_crosshair;
@@ -702,10 +731,16 @@ void CL_WriteDemoUserMessage( const byte *buffer, size_t size );
 qboolean CL_DemoReadMessage( byte *buffer, size_t *length );
 void CL_DemoInterpolateAngles( void );
 void CL_WriteDemoJumpTime( void );
+void CL_DemoMarkKeyframe( void );
+void CL_DemoBenchParse( int cmd, int bytes, double time );
+void CL_DemoBenchEmit( double time );
 void CL_CloseDemoHeader( void );
 void CL_StopPlayback( void );
 void CL_StopRecord( void );
 void CL_PlayDemo_f( void );
+void CL_DemoSeek_f( void );
+void CL_DemoForward_f( void );
+void CL_BenchDemo_f( void );
 void CL_StartDemos_f( void );
 void CL_Demos_f( void );
 void CL_DeleteDemo_f( void );
@@ -934,6 +969,8 @@ void S_StopBackgroundTrack( void );
 void S_StreamSetPause( int pause );
 void S_StartStreaming( void );
 void S_StopStreaming( void );
+void S_LockSoundTrack( void );
+void S_UnlockSoundTrack( void );
 void S_BeginRegistration( void );
 sound_t S_RegisterSound( const char *sample );
 void S_EndRegistration( void );
@@ -30,6 +30,17 @@ static string	s_sentenceImmediateName;	// keep dummy sentence name
 qboolean		s_registering = false;
 int		s_registration_sequence = 0;
 
+static struct
+{
+	size_t		resident;		// bytes of sound data in memory
+	int		hits;
+	int		misses;
+	int		evictions;
+	int		preloaded;
+	int		preloadNext;	// next s_knownSfx slot to examine by preloader
+	qboolean		preloading;
+} s_cache;
+
 /*
 =================
 S_SoundList_f
@@ -62,6 +73,9 @@ void S_SoundList_f( void )
 	Msg( "-------------------------------------------\n" );
 	Msg( "%i total sounds\n", totalSfx );
 	Msg( "%s total memory\n", Q_memprint( totalSize ));
+	Msg( "%s cache budget\n", s_cachesize->value > 0 ? Q_memprint( s_cachesize->value * 1024 * 1024 ) : "unlimited" );
+	Msg( "%i hits, %i misses, %i evictions, %i preloaded%s\n", s_cache.hits, s_cache.misses,
+		s_cache.evictions, s_cache.preloaded, s_cache.preloading ? " (in progress)" : "" );
 	Msg( "\n" );
 }
 
@@ -119,15 +133,103 @@ static wavdata_t *S_CreateDefaultSound( void )
 
 /*
 =================
-S_LoadSound
+S_SoundInUse
+
+sound data is referenced by mixer
 =================
 */
-wavdata_t *S_LoadSound( sfx_t *sfx )
+static qboolean S_SoundInUse( sfx_t *sfx )
 {
-	wavdata_t	*sc = NULL;
+	channel_t	*ch;
+	int	i;
 
-	if( !sfx ) return NULL;
-	if( sfx->cache ) return sfx->cache; // see if still in memory
+	for( i = 0, ch = channels; i < MAX_CHANNELS; i++, ch++ )
+	{
+		if( !ch->sfx ) continue;
+		if( ch->sfx == sfx || ch->pMixer.pData == sfx->cache )
+			return true;
+		if( ch->currentWord && ch->currentWord->pData == sfx->cache )
+			return true;
+	}
+
+	return false;
+}
+
+/*
+=================
+S_CacheIsFull
+=================
+*/
+static qboolean S_CacheIsFull( void )
+{
+	if( s_cachesize->value <= 0.0f )
+		return false;
+	return ( s_cache.resident >= (size_t)( s_cachesize->value * 1024 * 1024 ));
+}
+
+/*
+=================
+S_UncacheSound
+
+release sound data but keep sfx slot
+=================
+*/
+void S_UncacheSound( sfx_t *sfx )
+{
+	if( !sfx || !sfx->cache )
+		return;
+
+	s_cache.resident -= sfx->cache->size;
+	FS_FreeSound( sfx->cache );
+	sfx->cache = NULL;
+}
+
+/*
+=================
+S_CheckCacheBudget
+
+evict least recently used sounds until we fit into the budget
+=================
+*/
+static void S_CheckCacheBudget( sfx_t *keep )
+{
+	sfx_t	*sfx, *oldest;
+	int	i;
+
+	while( S_CacheIsFull( ))
+	{
+		oldest = NULL;
+
+		for( i = 0, sfx = s_knownSfx; i < s_numSfx; i++, sfx++ )
+		{
+			if( !sfx->cache || sfx == keep )
+				continue;
+
+			if( oldest && sfx->lastUsed >= oldest->lastUsed )
+				continue;
+
+			if( S_SoundInUse( sfx ))
+				continue;
+
+			oldest = sfx;
+		}
+
+		if( !oldest ) break; // everything is playing right now
+		S_UncacheSound( oldest );
+		s_cache.evictions++;
+	}
+}
+
+/*
+=================
+S_CacheSound
+
+load sound from disk
+=================
+*/
+static wavdata_t *S_CacheSound( sfx_t *sfx )
+{
+	wavdata_t	*sc = NULL;
 
 	if( Q_stricmp( sfx->name, "*default" ))
 	{
@@ -147,10 +249,75 @@ wavdata_t *S_LoadSound( sfx_t *sfx )
 		Sound_Process( &sc, SOUND_44k, sc->width, SOUND_RESAMPLE );
 
 	sfx->cache = sc;
+	sfx->lastUsed = host.framecount;
+	s_cache.resident += sc->size;
+	S_CheckCacheBudget( sfx );
 
 	return sfx->cache;
 }
 
+/*
+=================
+S_LoadSound
+=================
+*/
+wavdata_t *S_LoadSound( sfx_t *sfx )
+{
+	if( !sfx ) return NULL;
+
+	if( sfx->cache )
+	{
+		// see if still in memory
+		if( sfx->lastUsed != host.framecount )
+		{
+			sfx->lastUsed = host.framecount;
+			s_cache.hits++;
+		}
+		return sfx->cache;
+	}
+
+	s_cache.misses++;
+
+	return S_CacheSound( sfx );
+}
+
+/*
+=================
+S_UpdatePreload
+
+load precached sounds in background, few per frame
+=================
+*/
+void S_UpdatePreload( void )
+{
+	double	endtime;
+	sfx_t	*sfx;
+
+	if( !s_cache.preloading || s_registering )
+		return;
+
+	endtime = Sys_DoubleTime() + s_preload_time->value * 0.001;
+
+	for( ; s_cache.preloadNext < s_numSfx; s_cache.preloadNext++ )
+	{
+		sfx = &s_knownSfx[s_cache.preloadNext];
+
+		if( !sfx->name[0] || sfx->cache || sfx->touchFrame != s_registration_sequence )
+			continue;
+
+		// preloading should never push out used sounds
+		if( S_CacheIsFull( )) break;
+
+		if( s_preload_time->value > 0.0f && Sys_DoubleTime() > endtime )
+			return; // continue next frame
+
+		S_CacheSound( sfx );
+		s_cache.preloaded++;
+	}
+
+	s_cache.preloading = false;
+}
+
 // =======================================================================
 // Load a sound
 // =======================================================================
@@ -251,7 +418,7 @@ void S_FreeSound( sfx_t *sfx )
 		prev = &hashSfx->hashNext;
 	}
 
-	if( sfx->cache ) FS_FreeSound( sfx->cache );
+	S_UncacheSound( sfx );
 	memset( sfx, 0, sizeof( *sfx ));
 }
 
@@ -307,13 +474,14 @@ void S_EndRegistration( void )
 			S_FreeSound( sfx ); // don't need this sound
 	}
 
-	// load everything in
-	for( i = 0, sfx = s_knownSfx; i < s_numSfx; i++, sfx++ )
-	{
-		if( !sfx->name[0] ) continue;
-		S_LoadSound( sfx );
-	}
 	s_registering = false;
+
+	// load everything in, time-sliced by S_UpdatePreload
+	s_cache.preloadNext = 0;
+	s_cache.preloading = true;
+
+	if( s_preload_time->value <= 0.0f )
+		S_UpdatePreload();
 }
 
 /*
@@ -388,6 +556,7 @@ void S_FreeSounds( void )
 
 	memset( s_knownSfx, 0, sizeof( s_knownSfx ));
 	memset( s_sfxHashList, 0, sizeof( s_sfxHashList ));
+	memset( &s_cache, 0, sizeof( s_cache ));
 
 	s_numSfx = 0;
 }
\ No newline at end of file
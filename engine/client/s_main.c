@@ -55,6 +55,8 @@ convar_t		*s_refdb;
 convar_t		*s_cull;		// cull sounds by geometry
 convar_t		*s_test;		// cvar for testing new effects
 convar_t		*s_phs;
+convar_t		*s_cachesize;
+convar_t		*s_preload_time;
 
 /*
 =============================================================================
@@ -1995,6 +1997,7 @@ void SND_UpdateSound( void )
 
 	S_StreamBackgroundTrack ();
 	S_StreamSoundTrack ();
+	S_UpdatePreload ();
 
 	// mix some sound
 	S_UpdateChannels ();
@@ -2151,6 +2154,7 @@ void S_SoundInfo_f( void )
 	Msg( "%5d total_channels\n", total_channels );
 
 	S_PrintBackgroundTrackState ();
+	S_PrintStreamingState ();
 }
 
 /*
@@ -2183,6 +2187,8 @@ qboolean S_Init( void )
 	s_cull = Cvar_Get( "s_cull", "0", FCVAR_ARCHIVE, "cull sounds by geometry" );
 	s_test = Cvar_Get( "s_test", "0", 0, "engine developer cvar for quick testing new features" );
 	s_phs = Cvar_Get( "s_phs", "0", FCVAR_ARCHIVE, "cull sounds by PHS" );
+	s_cachesize = Cvar_Get( "s_cachesize", "64", FCVAR_ARCHIVE, "sound cache budget in megabytes (0 is unlimited)" );
+	s_preload_time = Cvar_Get( "s_preload_time", "2", FCVAR_ARCHIVE, "milliseconds per frame spent on precached sounds loading (0 is load all at once)" );
 
 	Cmd_AddCommand( "play", S_Play_f, "playing a specified sound file" );
 	Cmd_AddCommand( "playvol", S_PlayVol_f, "playing a specified sound file with specified volume" );
@@ -2212,6 +2218,7 @@ qboolean S_Init( void )
 	MIX_InitAllPaintbuffers ();
 	SX_Init ();
 	S_InitScaletable ();
+	S_InitStreaming ();
 	S_StopAllSounds ( true );
 	VOX_Init ();
 
@@ -2238,6 +2245,9 @@ void S_Shutdown( void )
 	Cmd_RemoveCommand( "spk" );
 
 	S_StopAllSounds (false);
+	S_StopBackgroundTrack ();
+	S_StopStreaming ();
+	S_ShutdownStreaming ();
 	S_FreeRawChannels ();
 	S_FreeSounds ();
 	VOX_Shutdown ();
@@ -20,6 +20,313 @@ GNU General Public License for more details.
 static bg_track_t		s_bgTrack;
 static musicfade_t		musicfade;	// controlled by game dlls
 
+static struct
+{
+	HANDLE		thread;		// NULL if decoding is synchronous
+	HANDLE		wakeup;		// signalled when mixer consumes some data
+	volatile qboolean	shutdown;
+	streamring_t	music;		// background track
+	streamring_t	soundtrack;	// cinematic audio
+} s_stream;
+
+/*
+=================
+S_ReadBackgroundTrack
+
+called with music lock held
+=================
+*/
+static long S_ReadBackgroundTrack( void *buffer, long bytes, qboolean *eof )
+{
+	long	r;
+
+	r = FS_ReadStream( s_bgTrack.stream, bytes, buffer );
+
+	// decoders return nothing only at the end of the file
+	if( r <= 0 ) *eof = true;
+
+	return r;
+}
+
+/*
+=================
+S_ReadSoundTrack
+
+called with soundtrack lock held,
+movie audio never ends by itself: it's padded
+with silence until cinematic is stopped
+=================
+*/
+static long S_ReadSoundTrack( void *buffer, long bytes, qboolean *eof )
+{
+	return SCR_GetAudioChunk( buffer, bytes );
+}
+
+/*
+=================
+S_DecodeAhead
+
+decode next chunk of the stream into the ring,
+returns false if nothing was decoded
+=================
+*/
+static qboolean S_DecodeAhead( streamring_t *ring )
+{
+	int	size, frame, r;
+	uint	head, offset;
+	qboolean	eof = false;
+
+	if( !ring->active || ring->eof )
+		return false;
+
+	EnterCriticalSection( &ring->lock );
+
+	// stream may be stopped while we are waiting for lock
+	if( !ring->active || ring->eof )
+	{
+		LeaveCriticalSection( &ring->lock );
+		return false;
+	}
+
+	frame = ring->width * ring->channels;
+	head = ring->head;
+	offset = head & STREAM_RING_MASK;
+
+	// contiguous free space, frame size is always divisor of the ring size
+	size = STREAM_RING_SIZE - (head - ring->tail);
+	size = min( size, STREAM_RING_SIZE - offset );
+	size = min( size, STREAM_CHUNK_SIZE );
+	size -= size % frame;
+
+	if( size <= 0 )
+	{
+		// ring is full
+		LeaveCriticalSection( &ring->lock );
+		return false;
+	}
+
+	// short read is not the end of the stream, try again later
+	r = ring->read( ring->data + offset, size, &eof );
+	if( eof ) ring->eof = true;
+	r = max( r, 0 );
+	r -= r % frame;
+
+	if( r > 0 )
+	{
+		ring->decoded += r;
+		// publish decoded data for the mixer
+		InterlockedExchange( (long *)&ring->head, head + r );
+	}
+
+	LeaveCriticalSection( &ring->lock );
+
+	return ( r > 0 );
+}
+
+/*
+=================
+S_ReadStreamRing
+
+copy decoded pcm from the ring, never blocks
+=================
+*/
+static int S_ReadStreamRing( streamring_t *ring, byte *buffer, int bytes )
+{
+	int	frame, first;
+	uint	avail, tail, offset;
+
+	frame = ring->width * ring->channels;
+	tail = ring->tail;
+
+	// synchronous mode: decode only as much as we need right now
+	if( !s_stream.thread )
+	{
+		while( ring->head - tail < (uint)bytes && S_DecodeAhead( ring ));
+	}
+
+	avail = ring->head - tail;
+	if( (uint)bytes > avail ) bytes = avail;
+	bytes -= bytes % frame;
+
+	if( bytes <= 0 )
+	{
+		if( !ring->eof && ring->decoded )
+			ring->underruns++;
+		return 0;
+	}
+
+	offset = tail & STREAM_RING_MASK;
+	first = min( bytes, STREAM_RING_SIZE - offset );
+
+	memcpy( buffer, ring->data + offset, first );
+	if( first < bytes ) memcpy( buffer + first, ring->data, bytes - first );
+
+	// release space for the decoder
+	InterlockedExchange( (long *)&ring->tail, tail + bytes );
+	if( s_stream.thread ) SetEvent( s_stream.wakeup );
+
+	return bytes;
+}
+
+/*
+=================
+S_StartStreamRing
+
+stream must be ready to read
+=================
+*/
+static void S_StartStreamRing( streamring_t *ring, wavdata_t *info )
+{
+	EnterCriticalSection( &ring->lock );
+	ring->head = ring->tail = 0;
+	ring->decoded = 0;
+	ring->eof = false;
+	ring->rate = info->rate;
+	ring->width = info->width;
+	ring->channels = info->channels;
+	ring->active = true;
+	LeaveCriticalSection( &ring->lock );
+
+	// prefetch first chunk to avoid a gap before the decoder wakes up
+	S_DecodeAhead( ring );
+	if( s_stream.thread ) SetEvent( s_stream.wakeup );
+}
+
+/*
+=================
+S_StopStreamRing
+
+after this call producer never touches the stream
+=================
+*/
+static void S_StopStreamRing( streamring_t *ring )
+{
+	EnterCriticalSection( &ring->lock );
+	ring->active = false;
+	LeaveCriticalSection( &ring->lock );
+}
+
+/*
+=================
+S_StreamThread
+
+decode music and soundtracks ahead of the mixer
+=================
+*/
+static DWORD WINAPI S_StreamThread( void *unused )
+{
+	qboolean	decoded;
+
+	while( !s_stream.shutdown )
+	{
+		decoded = S_DecodeAhead( &s_stream.music );
+		decoded |= S_DecodeAhead( &s_stream.soundtrack );
+
+		// both rings are full or idle
+		if( !decoded ) WaitForSingleObject( s_stream.wakeup, 20 );
+	}
+
+	return 0;
+}
+
+/*
+=================
+S_InitStreaming
+=================
+*/
+void S_InitStreaming( void )
+{
+	DWORD	id;
+
+	memset( &s_stream, 0, sizeof( s_stream ));
+
+	s_stream.music.data = Mem_Alloc( sndpool, STREAM_RING_SIZE );
+	s_stream.music.read = S_ReadBackgroundTrack;
+	InitializeCriticalSection( &s_stream.music.lock );
+
+	s_stream.soundtrack.data = Mem_Alloc( sndpool, STREAM_RING_SIZE );
+	s_stream.soundtrack.read = S_ReadSoundTrack;
+	InitializeCriticalSection( &s_stream.soundtrack.lock );
+
+	if( Sys_CheckParm( "-nostreamthread" ))
+		return;
+
+	s_stream.wakeup = CreateEvent( NULL, FALSE, FALSE, NULL );
+	if( s_stream.wakeup ) s_stream.thread = CreateThread( NULL, 0, S_StreamThread, NULL, 0, &id );
+
+	if( !s_stream.thread )
+	{
+		MsgDev( D_WARN, "S_InitStreaming: couldn't create decode thread, using synchronous decoding\n" );
+		if( s_stream.wakeup ) CloseHandle( s_stream.wakeup );
+		s_stream.wakeup = NULL;
+	}
+}
+
+/*
+=================
+S_ShutdownStreaming
+
+all streams must be stopped before
+=================
+*/
+void S_ShutdownStreaming( void )
+{
+	if( s_stream.thread )
+	{
+		s_stream.shutdown = true;
+		SetEvent( s_stream.wakeup );
+		WaitForSingleObject( s_stream.thread, INFINITE );
+		CloseHandle( s_stream.thread );
+		CloseHandle( s_stream.wakeup );
+	}
+
+	DeleteCriticalSection( &s_stream.music.lock );
+	DeleteCriticalSection( &s_stream.soundtrack.lock );
+	memset( &s_stream, 0, sizeof( s_stream ));
+}
+
+/*
+=================
+S_LockSoundTrack
+
+movie decoder is not thread-safe, so video frames
+must be fetched while soundtrack producer is idle
+=================
+*/
+void S_LockSoundTrack( void )
+{
+	if( !dma.initialized ) return;
+	EnterCriticalSection( &s_stream.soundtrack.lock );
+}
+
+/*
+=================
+S_UnlockSoundTrack
+=================
+*/
+void S_UnlockSoundTrack( void )
+{
+	if( !dma.initialized ) return;
+	LeaveCriticalSection( &s_stream.soundtrack.lock );
+}
+
+/*
+=================
+S_PrintStreamingState
+=================
+*/
+void S_PrintStreamingState( void )
+{
+	streamring_t	*music = &s_stream.music;
+	streamring_t	*track = &s_stream.soundtrack;
+
+	Msg( "stream decoding: %s\n", s_stream.thread ? "threaded" : "synchronous" );
+	Msg( "music: %3i%% buffered, %i kb decoded, %i underruns\n", ( music->head - music->tail ) * 100 / STREAM_RING_SIZE,
+		music->decoded >> 10, music->underruns );
+	Msg( "soundtrack: %3i%% buffered, %i kb decoded, %i underruns\n", ( track->head - track->tail ) * 100 / STREAM_RING_SIZE,
+		track->decoded >> 10, track->underruns );
+}
+
 /*
 =================
 S_PrintBackgroundTrackState
@@ -96,11 +403,15 @@ void S_StartBackgroundTrack( const char *introTrack, const char *mainTrack, long
 	memset( &musicfade, 0, sizeof( musicfade )); // clear any soundfade
 	s_bgTrack.source = cls.key_dest;
 
+	if( !s_bgTrack.stream ) return;
+
 	if( position != 0 )
 	{
 		// restore message, update song position
 		FS_SetStreamPos( s_bgTrack.stream, position );
 	}
+
+	S_StartStreamRing( &s_stream.music, FS_StreamInfo( s_bgTrack.stream ));
 }
 
 /*
@@ -115,6 +426,7 @@ void S_StopBackgroundTrack( void )
 	if( !dma.initialized ) return;
 	if( !s_bgTrack.stream ) return;
 
+	S_StopStreamRing( &s_stream.music );
 	FS_FreeStream( s_bgTrack.stream );
 	memset( &s_bgTrack, 0, sizeof( bg_track_t ));
 	memset( &musicfade, 0, sizeof( musicfade ));
@@ -157,7 +469,12 @@ qboolean S_StreamGetCurrentState( char *currentTrack, char *loopTrack, int *posi
 	}
 
 	if( position )
+	{
+		// NOTE: this is decoder position, a bit ahead of the mixer
+		EnterCriticalSection( &s_stream.music.lock );
 		*position = FS_GetStreamPos( s_bgTrack.stream );
+		LeaveCriticalSection( &s_stream.music.lock );
+	}
 
 	return true;
 }
@@ -201,47 +518,48 @@ void S_StreamBackgroundTrack( void )
 
 	while( ch->s_rawend < soundtime + ch->max_samples )
 	{
-		wavdata_t	*info = FS_StreamInfo( s_bgTrack.stream );
+		streamring_t	*ring = &s_stream.music;
+		int		frame = ring->width * ring->channels;
 
 		bufferSamples = ch->max_samples - (ch->s_rawend - soundtime);
 
 		// decide how much data needs to be read from the file
-		fileSamples = bufferSamples * ((float)info->rate / SOUND_DMA_SPEED );
+		fileSamples = bufferSamples * ((float)ring->rate / SOUND_DMA_SPEED );
 		if( fileSamples <= 1 ) return; // no more samples need
 
 		// our max buffer size
-		fileBytes = fileSamples * ( info->width * info->channels );
+		fileBytes = fileSamples * frame;
 
 		if( fileBytes > sizeof( raw ))
 		{
 			fileBytes = sizeof( raw );
-			fileSamples = fileBytes / ( info->width * info->channels );
+			fileSamples = fileBytes / frame;
 		}
 
-		// read
-		r = FS_ReadStream( s_bgTrack.stream, fileBytes, raw );
-
-		if( r < fileBytes )
-		{
-			fileBytes = r;
-			fileSamples = r / ( info->width * info->channels );
-		}
+		// read already decoded data
+		r = S_ReadStreamRing( ring, raw, fileBytes );
 
 		if( r > 0 )
 		{
 			// add to raw buffer
-			S_RawSamples( fileSamples, info->rate, info->width, info->channels, raw, S_RAW_SOUND_BACKGROUNDTRACK );
+			S_RawSamples( r / frame, ring->rate, ring->width, ring->channels, raw, S_RAW_SOUND_BACKGROUNDTRACK );
+		}
+		else if( !ring->eof )
+		{
+			return; // decoder is behind, try again next frame
 		}
 		else
 		{
 			// loop
 			if( s_bgTrack.loopName[0] )
 			{
+				S_StopStreamRing( ring );
 				FS_FreeStream( s_bgTrack.stream );
 				s_bgTrack.stream = FS_OpenStream( va( "media/%s", s_bgTrack.loopName ));
 				Q_strncpy( s_bgTrack.current, s_bgTrack.loopName, sizeof( s_bgTrack.current ));
 
 				if( !s_bgTrack.stream ) return;
+				S_StartStreamRing( ring, FS_StreamInfo( s_bgTrack.stream ));
 			}
 			else
 			{
@@ -260,9 +578,14 @@ S_StartStreaming
 */
 void S_StartStreaming( void )
 {
+	wavdata_t	*info;
+
 	if( !dma.initialized ) return;
 	// begin streaming movie soundtrack
 	s_listener.streaming = true;
+
+	if(( info = SCR_GetMovieInfo( )) != NULL )
+		S_StartStreamRing( &s_stream.soundtrack, info );
 }
 
 /*
@@ -273,6 +596,7 @@ S_StopStreaming
 void S_StopStreaming( void )
 {
 	if( !dma.initialized ) return;
+	S_StopStreamRing( &s_stream.soundtrack );
 	s_listener.streaming = false;
 }
 
@@ -302,38 +626,34 @@ void S_StreamSoundTrack( void )
 
 	while( ch->s_rawend < soundtime + ch->max_samples )
 	{
-		wavdata_t	*info = SCR_GetMovieInfo();
+		streamring_t	*ring = &s_stream.soundtrack;
+		int		frame = ring->width * ring->channels;
 
-		if( !info ) break;	// bad soundtrack?
+		if( !SCR_GetMovieInfo( ) || !ring->active )
+			break;	// bad soundtrack?
 
 		bufferSamples = ch->max_samples - (ch->s_rawend - soundtime);
 
 		// decide how much data needs to be read from the file
-		fileSamples = bufferSamples * ((float)info->rate / SOUND_DMA_SPEED );
+		fileSamples = bufferSamples * ((float)ring->rate / SOUND_DMA_SPEED );
 		if( fileSamples <= 1 ) return; // no more samples need
 
 		// our max buffer size
-		fileBytes = fileSamples * ( info->width * info->channels );
+		fileBytes = fileSamples * frame;
 
 		if( fileBytes > sizeof( raw ))
 		{
 			fileBytes = sizeof( raw );
-			fileSamples = fileBytes / ( info->width * info->channels );
+			fileSamples = fileBytes / frame;
 		}
 
-		// read audio stream
-		r = SCR_GetAudioChunk( raw, fileBytes );
-
-		if( r < fileBytes )
-		{
-			fileBytes = r;
-			fileSamples = r / ( info->width * info->channels );
-		}
+		// read already decoded audio stream
+		r = S_ReadStreamRing( ring, raw, fileBytes );
 
 		if( r > 0 )
 		{
 			// add to raw buffer
-			S_RawSamples( fileSamples, info->rate, info->width, info->channels, raw, S_RAW_SOUND_SOUNDTRACK );
+			S_RawSamples( r / frame, ring->rate, ring->width, ring->channels, raw, S_RAW_SOUND_SOUNDTRACK );
 		}
 		else break; // no more samples for this frame
 	}
@@ -389,8 +389,7 @@ void VOX_FreeWord( channel_t *pchan )
 		// If this wave wasn't precached by the game code
 		if( !pchan->words[pchan->wordIndex].fKeepCached )
 		{
-			FS_FreeSound( pchan->words[pchan->wordIndex].sfx->cache );
-			pchan->words[pchan->wordIndex].sfx->cache = NULL;
+			S_UncacheSound( pchan->words[pchan->wordIndex].sfx );
 			pchan->words[pchan->wordIndex].sfx = NULL;
 		}
 	}
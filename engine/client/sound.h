@@ -101,6 +101,7 @@ typedef struct sfx_s
 	wavdata_t		*cache;
 
 	int		touchFrame;
+	uint		lastUsed;		// host.framecount of last access, for LRU eviction
 	uint		hashValue;
 	struct sfx_s	*hashNext;
 } sfx_t;
@@ -225,6 +226,30 @@ typedef struct
 	int		source;		// may be game, menu, etc
 } bg_track_t;
 
+#define STREAM_RING_SIZE	(MAX_RAW_SAMPLES * 16)	// decoded bytes kept ahead of the mixer (power of two)
+#define STREAM_RING_MASK	(STREAM_RING_SIZE - 1)
+#define STREAM_CHUNK_SIZE	(MAX_RAW_SAMPLES * 2)	// max bytes decoded per one read call
+
+// single producer (decode thread), single consumer (mixer) ring of decoded pcm
+typedef struct
+{
+	byte		*data;		// STREAM_RING_SIZE bytes
+	volatile uint	head;		// write position, advanced by producer only
+	volatile uint	tail;		// read position, advanced by consumer only
+	volatile qboolean	eof;		// producer reached end of the stream
+	volatile qboolean	active;		// producer is allowed to read the stream
+	CRITICAL_SECTION	lock;		// serialize stream access between producer and start\stop
+	long		(*read)( void *buffer, long bytes, qboolean *eof );
+
+	int		rate;		// format of decoded data
+	int		width;
+	int		channels;
+
+	// statistics
+	uint		decoded;		// total decoded bytes
+	uint		underruns;	// mixer was starved while stream is still playing
+} streamring_t;
+
 /*
 ====================================================================
 
@@ -264,6 +289,8 @@ extern convar_t	*s_mixahead;
 extern convar_t	*s_lerping;
 extern convar_t	*dsp_off;
 extern convar_t	*s_test;		// cvar to testify new effects
+extern convar_t	*s_cachesize;
+extern convar_t	*s_preload_time;
 
 void S_InitScaletable( void );
 wavdata_t *S_LoadSound( sfx_t *sfx );
@@ -291,6 +318,8 @@ char *S_SkipSoundChar( const char *pch );
 sfx_t *S_FindName( const char *name, int *pfInCache );
 sound_t S_RegisterSound( const char *name );
 void S_FreeSound( sfx_t *sfx );
+void S_UncacheSound( sfx_t *sfx );
+void S_UpdatePreload( void );
 
 // s_dsp.c
 void SX_Init( void );
@@ -330,8 +359,11 @@ void SND_CloseMouth( channel_t *ch );
 //
 // s_stream.c
 //
+void S_InitStreaming( void );
+void S_ShutdownStreaming( void );
 void S_StreamSoundTrack( void );
 void S_StreamBackgroundTrack( void );
+void S_PrintStreamingState( void );
 qboolean S_StreamGetCurrentState( char *currentTrack, char *loopTrack, int *position );
 void S_PrintBackgroundTrackState( void );
 void S_FadeMusicVolume( float fadePercent );
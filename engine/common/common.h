@@ -747,6 +747,14 @@ void MD5Final( byte digest[16], MD5Context_t *ctx );
 qboolean MD5_HashFile( byte digest[16], const char *pszFileName, uint seed[4] );
 uint Com_HashKey( const char *string, uint hashSize );
 
+//
+// lzss.c
+//
+qboolean LZSS_IsCompressed( const byte *in, int inlen );
+int LZSS_GetActualSize( const byte *in, int inlen );
+int LZSS_Compress( const byte *in, int inlen, byte *out, int outlen );
+int LZSS_Decompress( const byte *in, int inlen, byte *out, int outlen );
+
 //
 // hpak.c
 //
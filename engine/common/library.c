@@ -515,6 +515,43 @@ static void FreeNameFuncGlobals( dll_user_t *hInst )
 	hInst->funcs = NULL;
 }
 
+static uint LibraryFuncHash( dword function )
+{
+	// functions are usually aligned by 16 bytes
+	return (( function >> 4 ) ^ ( function >> 16 )) & ( LIBRARY_HASH_SIZE - 1 );
+}
+
+/*
+================
+LibraryBuildHashTables
+
+chains are built from the last export so
+the first one with same name stays in front
+================
+*/
+static void LibraryBuildHashTables( dll_user_t *hInst )
+{
+	uint	hash;
+	int	i;
+
+	memset( hInst->nameHash, 0xFF, sizeof( hInst->nameHash ));	// fill with -1
+	memset( hInst->funcHash, 0xFF, sizeof( hInst->funcHash ));
+
+	for( i = hInst->num_ordinals - 1; i >= 0; i-- )
+	{
+		if( hInst->names[i] )
+		{
+			hash = Com_HashKey( hInst->names[i], LIBRARY_HASH_SIZE );
+			hInst->nameNext[i] = hInst->nameHash[hash];
+			hInst->nameHash[hash] = i;
+		}
+
+		hash = LibraryFuncHash( hInst->funcs[hInst->ordinals[i]] );
+		hInst->funcNext[i] = hInst->funcHash[hash];
+		hInst->funcHash[hash] = i;
+	}
+}
+
 char *GetMSVCName( const char *in_name )
 {
 	char	*pos, *out_name;
@@ -744,6 +781,8 @@ qboolean LibraryLoadSymbols( dll_user_t *hInst )
 		}
 	}
 
+	LibraryBuildHashTables( hInst );
+
 	if( p_Names ) Mem_Free( p_Names );
 	return true;
 table_error:
@@ -853,10 +892,10 @@ dword Com_FunctionFromName( void *hInstance, const char *pName )
 	dll_user_t	*hInst = (dll_user_t *)hInstance;
 	int		i, index;
 
-	if( !hInst || !hInst->hInstance )
+	if( !hInst || !hInst->hInstance || !hInst->num_ordinals )
 		return 0;
 
-	for( i = 0; i < hInst->num_ordinals; i++ )
+	for( i = hInst->nameHash[Com_HashKey( pName, LIBRARY_HASH_SIZE )]; i != -1; i = hInst->nameNext[i] )
 	{
 		if( !Q_strcmp( pName, hInst->names[i] ))
 		{
@@ -873,10 +912,10 @@ const char *Com_NameForFunction( void *hInstance, dword function )
 	dll_user_t	*hInst = (dll_user_t *)hInstance;
 	int		i, index;
 
-	if( !hInst || !hInst->hInstance )
+	if( !hInst || !hInst->hInstance || !hInst->num_ordinals )
 		return NULL;
 
-	for( i = 0; i < hInst->num_ordinals; i++ )
+	for( i = hInst->funcHash[LibraryFuncHash( function - hInst->funcBase )]; i != -1; i = hInst->funcNext[i] )
 	{
 		index = hInst->ordinals[i];
 
@@ -20,6 +20,7 @@ GNU General Public License for more details.
 #define NT_SIGNATURE		0x00004550	// PE00
 #define NUMBER_OF_DIRECTORY_ENTRIES	16
 #define MAX_LIBRARY_EXPORTS		4096
+#define LIBRARY_HASH_SIZE		4096		// must be power of two
 
 typedef struct
 {	
@@ -148,6 +149,12 @@ typedef struct dll_user_s
 	char	*names[MAX_LIBRARY_EXPORTS];	// max 4096 exports supported
 	int	num_ordinals;		// actual exports count
 	dword	funcBase;			// base offset
+
+	// hashed lookups for FunctionFromName and NameForFunction, -1 terminated chains
+	short	nameHash[LIBRARY_HASH_SIZE];
+	short	nameNext[MAX_LIBRARY_EXPORTS];
+	short	funcHash[LIBRARY_HASH_SIZE];
+	short	funcNext[MAX_LIBRARY_EXPORTS];
 } dll_user_t;
 
 dll_user_t *FS_FindLibrary( const char *dllname, qboolean directpath );
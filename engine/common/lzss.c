@@ -0,0 +1,232 @@
+/*
+lzss.c - fast LZ77 compression for network and save data
+Copyright (C) 2017 Uncle Mike
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+
+/*
+compressed block layout
+-------------
+4	ident "LZSS"
+4	uncompressed size
+and then groups of eight tokens, each group is prefixed with a byte of flags.
+flag 0 is a literal byte, flag 1 is a back reference stored in two bytes:
+12 bits of distance - 1 and 4 bits of length - LZSS_MIN_MATCH
+*/
+#define LZSS_IDENT		(('S'<<24)+('S'<<16)+('Z'<<8)+'L')	// little-endian "LZSS"
+#define LZSS_WINDOW_SIZE	4096
+#define LZSS_MIN_MATCH	3
+#define LZSS_MAX_MATCH	(15 + LZSS_MIN_MATCH)
+#define LZSS_HASH_SIZE	4096
+#define LZSS_HASH( p )	((( p[0] << 4 ) ^ ( p[1] << 2 ) ^ p[2] ^ ( p[0] >> 4 )) & ( LZSS_HASH_SIZE - 1 ))
+
+typedef struct
+{
+	int		ident;
+	int		size;
+} lzss_header_t;
+
+/*
+================
+LZSS_IsCompressed
+================
+*/
+qboolean LZSS_IsCompressed( const byte *in, int inlen )
+{
+	lzss_header_t	header;
+
+	if( !in || inlen < sizeof( header ))
+		return false;
+
+	memcpy( &header, in, sizeof( header ));
+
+	return ( header.ident == LZSS_IDENT );
+}
+
+/*
+================
+LZSS_GetActualSize
+
+returns uncompressed size or 0 for invalid block
+================
+*/
+int LZSS_GetActualSize( const byte *in, int inlen )
+{
+	lzss_header_t	header;
+
+	if( !LZSS_IsCompressed( in, inlen ))
+		return 0;
+
+	memcpy( &header, in, sizeof( header ));
+
+	return Q_max( header.size, 0 );
+}
+
+/*
+================
+LZSS_Compress
+
+returns size of compressed block or 0 when the
+output doesn't fit into outlen, caller should send
+the data uncompressed in this case
+================
+*/
+int LZSS_Compress( const byte *in, int inlen, byte *out, int outlen )
+{
+	const byte	*src = in, *end = in + inlen;
+	byte		*dst, *dstend = out + outlen;
+	byte		*flags = NULL;
+	int		hash[LZSS_HASH_SIZE];
+	lzss_header_t	header;
+	int		i, bit = 8;
+
+	if( !in || inlen <= 0 || outlen <= sizeof( header ))
+		return 0;
+
+	memset( hash, 0xFF, sizeof( hash ));	// fill with -1
+	dst = out + sizeof( header );
+
+	while( src < end )
+	{
+		int	pos = src - in;
+		int	len = 0, dist = 0;
+
+		if( bit == 8 )
+		{
+			if( dst >= dstend )
+				return 0;
+			flags = dst++;
+			*flags = 0;
+			bit = 0;
+		}
+
+		// only the latest position for each hash is kept, this is enough
+		// for repetitive network data and keeps the compressor very fast
+		if(( end - src ) >= LZSS_MIN_MATCH )
+		{
+			int	h = LZSS_HASH( src );
+			int	ref = hash[h];
+
+			hash[h] = pos;
+
+			if( ref >= 0 && ( pos - ref ) <= LZSS_WINDOW_SIZE )
+			{
+				int	maxlen = Q_min( end - src, LZSS_MAX_MATCH );
+				const byte	*match = in + ref;
+
+				while( len < maxlen && match[len] == src[len] )
+					len++;
+				dist = pos - ref;
+			}
+		}
+
+		if( len >= LZSS_MIN_MATCH )
+		{
+			if(( dst + 2 ) > dstend )
+				return 0;
+
+			*flags |= BIT( bit );
+			dst[0] = (byte)(( dist - 1 ) >> 4 );
+			dst[1] = (byte)(((( dist - 1 ) & 15 ) << 4 ) | ( len - LZSS_MIN_MATCH ));
+			dst += 2;
+
+			// remember positions inside the match too
+			for( i = 1; i < len && ( end - src - i ) >= LZSS_MIN_MATCH; i++ )
+				hash[LZSS_HASH(( src + i ))] = pos + i;
+			src += len;
+		}
+		else
+		{
+			if( dst >= dstend )
+				return 0;
+			*dst++ = *src++;
+		}
+
+		bit++;
+	}
+
+	header.ident = LZSS_IDENT;
+	header.size = inlen;
+	memcpy( out, &header, sizeof( header ));
+
+	return dst - out;
+}
+
+/*
+================
+LZSS_Decompress
+
+returns uncompressed size or -1 on corrupted
+block or when output buffer is too small
+================
+*/
+int LZSS_Decompress( const byte *in, int inlen, byte *out, int outlen )
+{
+	const byte	*src, *end = in + inlen;
+	byte		*dst = out, *dstend;
+	int		size, flags = 0;
+	int		bit = 8;
+
+	if( !LZSS_IsCompressed( in, inlen ))
+		return -1;
+
+	size = LZSS_GetActualSize( in, inlen );
+
+	if( size > outlen )
+		return -1;
+
+	src = in + sizeof( lzss_header_t );
+	dstend = out + size;
+
+	while( dst < dstend )
+	{
+		if( bit == 8 )
+		{
+			if( src >= end )
+				return -1;
+			flags = *src++;
+			bit = 0;
+		}
+
+		if( FBitSet( flags, BIT( bit )))
+		{
+			const byte	*ref;
+			int		dist, len;
+
+			if(( src + 2 ) > end )
+				return -1;
+
+			dist = (( src[0] << 4 ) | ( src[1] >> 4 )) + 1;
+			len = ( src[1] & 15 ) + LZSS_MIN_MATCH;
+			src += 2;
+
+			if( dist > ( dst - out ) || len > ( dstend - dst ))
+				return -1;
+
+			// source and destination may overlap
+			for( ref = dst - dist; len > 0; len-- )
+				*dst++ = *ref++;
+		}
+		else
+		{
+			if( src >= end )
+				return -1;
+			*dst++ = *src++;
+		}
+
+		bit++;
+	}
+
+	return size;
+}
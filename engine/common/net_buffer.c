@@ -21,11 +21,12 @@ GNU General Public License for more details.
 //#define DEBUG_NET_MESSAGES_SEND
 //#define DEBUG_NET_MESSAGES_READ
 
-// precalculated bit masks for WriteUBitLong.
-// Using these tables instead of doing the calculations
-// gives a 33% speedup in WriteUBitLong.
-static dword	BitWriteMasks[32][33];
-static dword	ExtraMasks[32];
+// bits are accumulated in a 64-bit register so a field
+// that spans two dwords is written with a single merge
+typedef unsigned __int64	qword;
+
+// precalculated masks for ReadUBitLong and WriteUBitLong
+static dword	ExtraMasks[33];
 
 short MSG_BigShort( short swap )
 {
@@ -34,22 +35,11 @@ short MSG_BigShort( short swap )
 
 void MSG_InitMasks( void )
 {
-	uint	startbit, endbit;
-	uint	maskBit, nBitsLeft;
-
-	for( startbit = 0; startbit < 32; startbit++ )
-	{
-		for( nBitsLeft = 0; nBitsLeft < 33; nBitsLeft++ )
-		{
-			endbit = startbit + nBitsLeft;
-
-			BitWriteMasks[startbit][nBitsLeft] = (uint)BIT( startbit ) - 1;
-			if( endbit < 32 ) BitWriteMasks[startbit][nBitsLeft] |= ~((uint)BIT( endbit ) - 1 );
-		}
-	}
+	uint	maskBit;
 
 	for( maskBit = 0; maskBit < 32; maskBit++ )
 		ExtraMasks[maskBit] = (uint)BIT( maskBit ) - 1;
+	ExtraMasks[32] = 0xFFFFFFFF;
 }
  
 void MSG_InitExt( sizebuf_t *sb, const char *pDebugName, void *pData, int nBytes, int nMaxBits )
@@ -138,30 +128,28 @@ void MSG_WriteUBitLong( sizebuf_t *sb, uint curData, int numbits )
 	}
 	else
 	{
-		int	nBitsLeft = numbits;
-		int	iCurBit = sb->iCurBit;
-		uint	iDWord = iCurBit >> 5;	// Mask in a dword.
-		dword	iCurBitMasked;
-		int	nBitsWritten;
-
-		Assert(( iDWord * 4 + sizeof( long )) <= (uint)MSG_GetMaxBytes( sb ));
+		dword	*pDWord = (dword *)sb->pData + ( sb->iCurBit >> 5 );
+		int	iCurBitMasked = sb->iCurBit & 31;
+		dword	mask = ExtraMasks[numbits];
 
-		iCurBitMasked = iCurBit & 31;
-		((dword *)sb->pData)[iDWord] &= BitWriteMasks[iCurBitMasked][nBitsLeft];
-		((dword *)sb->pData)[iDWord] |= curData << iCurBitMasked;
+		Assert((( sb->iCurBit >> 5 ) * 4 + sizeof( long )) <= (uint)MSG_GetMaxBytes( sb ));
 
-		// did it span a dword?
-		nBitsWritten = 32 - iCurBitMasked;
+		curData &= mask;
 
-		if( nBitsWritten < nBitsLeft )
+		if( iCurBitMasked + numbits <= 32 )
 		{
-			nBitsLeft -= nBitsWritten;
-			iCurBit += nBitsWritten;
-			curData >>= nBitsWritten;
+			// fits into the current dword
+			pDWord[0] = ( pDWord[0] & ~( mask << iCurBitMasked )) | ( curData << iCurBitMasked );
+		}
+		else
+		{
+			// spans a dword, merge both of them at once
+			qword	reg = (qword)pDWord[0] | ((qword)pDWord[1] << 32 );
+			qword	regmask = (qword)mask << iCurBitMasked;
 
-			iCurBitMasked = iCurBit & 31;
-			((dword *)sb->pData)[iDWord+1] &= BitWriteMasks[iCurBitMasked][nBitsLeft];
-			((dword *)sb->pData)[iDWord+1] |= curData << iCurBitMasked;
+			reg = ( reg & ~regmask ) | ((qword)curData << iCurBitMasked );
+			pDWord[0] = (dword)reg;
+			pDWord[1] = (dword)( reg >> 32 );
 		}
 		sb->iCurBit += numbits;
 	}
@@ -200,7 +188,14 @@ void MSG_WriteBitLong( sizebuf_t *sb, uint data, int numbits, qboolean bSigned )
 	else MSG_WriteUBitLong( sb, data, numbits );
 }
 
-qboolean MSG_WriteBits( sizebuf_t *sb, const void *pData, int nBits )
+/*
+=======================
+MSG_WriteBitsGeneric
+
+piecewise copy, used when buffer overflows
+=======================
+*/
+static qboolean MSG_WriteBitsGeneric( sizebuf_t *sb, const void *pData, int nBits )
 {
 	byte	*pOut = (byte *)pData;
 	int	nBitsLeft = nBits;
@@ -241,6 +236,66 @@ qboolean MSG_WriteBits( sizebuf_t *sb, const void *pData, int nBits )
 	return !sb->bOverflow;
 }
 
+/*
+=======================
+MSG_WriteBits
+
+byte-aligned destination is a plain memcpy,
+otherwise source is shifted through 64-bit register
+=======================
+*/
+qboolean MSG_WriteBits( sizebuf_t *sb, const void *pData, int nBits )
+{
+	const byte	*pIn = (const byte *)pData;
+	int		nBytes = nBits >> 3;
+	int		shift = sb->iCurBit & 7;
+	byte		*pOut;
+	qword		reg;
+
+	if( nBytes < 4 || ( sb->iCurBit + nBits ) > sb->nDataBits )
+		return MSG_WriteBitsGeneric( sb, pData, nBits );
+
+	pOut = sb->pData + ( sb->iCurBit >> 3 );
+
+	if( !shift )
+	{
+		memcpy( pOut, pIn, nBytes );
+		pIn += nBytes;
+	}
+	else
+	{
+		int	i = nBytes;
+
+		// keep the bits that already written into first byte
+		reg = *pOut & ExtraMasks[shift];
+
+		for( ; i >= 4; i -= 4, pIn += 4, pOut += 4 )
+		{
+			reg |= (qword)(*(dword *)pIn) << shift;
+			*(dword *)pOut = (dword)reg;
+			reg >>= 32;
+		}
+
+		for( ; i > 0; i--, pIn++, pOut++ )
+		{
+			reg |= (qword)*pIn << shift;
+			*pOut = (byte)reg;
+			reg >>= 8;
+		}
+
+		// flush the rest, leave the upper bits untouched
+		*pOut = ( *pOut & ~ExtraMasks[shift] ) | (byte)reg;
+	}
+
+	sb->iCurBit += nBytes << 3;
+
+	// Read the remaining bits.
+	if( nBits & 7 )
+		MSG_WriteUBitLong( sb, pIn[0], nBits & 7 );
+
+	return !sb->bOverflow;
+}
+
 void MSG_WriteBitAngle( sizebuf_t *sb, float fAngle, int numbits )
 {
 	uint	mask, shift;
@@ -380,8 +435,9 @@ int MSG_ReadOneBit( sizebuf_t *sb )
 
 uint MSG_ReadUBitLong( sizebuf_t *sb, int numbits )
 {
-	int	idword1;
-	uint	dword1, ret;
+	dword	*pDWord;
+	int	iCurBitMasked;
+	uint	ret;
 
 	if( numbits == 8 )
 	{
@@ -400,30 +456,23 @@ uint MSG_ReadUBitLong( sizebuf_t *sb, int numbits )
 
 	Assert( numbits > 0 && numbits <= 32 );
 
-	// Read the current dword.
-	idword1 = sb->iCurBit >> 5;
-	dword1 = ((uint *)sb->pData)[idword1];
-	dword1 >>= ( sb->iCurBit & 31 );	// get the bits we're interested in.
-
-	sb->iCurBit += numbits;
-	ret = dword1;
+	pDWord = (dword *)sb->pData + ( sb->iCurBit >> 5 );
+	iCurBitMasked = sb->iCurBit & 31;
 
-	// Does it span this dword?
-	if(( sb->iCurBit - 1 ) >> 5 == idword1 )
+	// does it span a dword?
+	if( iCurBitMasked + numbits <= 32 )
 	{
-		if( numbits != 32 )
-			ret &= ExtraMasks[numbits];
+		ret = pDWord[0] >> iCurBitMasked;
 	}
 	else
 	{
-		int	nExtraBits = sb->iCurBit & 31;
-		uint	dword2 = ((uint *)sb->pData)[idword1+1] & ExtraMasks[nExtraBits];
-		
-		// no need to mask since we hit the end of the dword.
-		// shift the second dword's part into the high bits.
-		ret |= (dword2 << ( numbits - nExtraBits ));
+		qword	reg = (qword)pDWord[0] | ((qword)pDWord[1] << 32 );
+		ret = (uint)( reg >> iCurBitMasked );
 	}
-	return ret;
+
+	sb->iCurBit += numbits;
+
+	return ret & ExtraMasks[numbits];
 }
 
 float MSG_ReadBitFloat( sizebuf_t *sb )
@@ -452,7 +501,14 @@ float MSG_ReadBitFloat( sizebuf_t *sb )
 	return *((float *)&val);
 }
 
-qboolean MSG_ReadBits( sizebuf_t *sb, void *pOutData, int nBits )
+/*
+=======================
+MSG_ReadBitsGeneric
+
+piecewise copy, used when buffer overflows
+=======================
+*/
+static qboolean MSG_ReadBitsGeneric( sizebuf_t *sb, void *pOutData, int nBits )
 {
 	byte	*pOut = (byte *)pOutData;
 	int	nBitsLeft = nBits;
@@ -490,6 +546,63 @@ qboolean MSG_ReadBits( sizebuf_t *sb, void *pOutData, int nBits )
 	return !sb->bOverflow;
 }
 
+/*
+=======================
+MSG_ReadBits
+
+byte-aligned source is a plain memcpy,
+otherwise it's shifted through 64-bit register
+=======================
+*/
+qboolean MSG_ReadBits( sizebuf_t *sb, void *pOutData, int nBits )
+{
+	byte		*pOut = (byte *)pOutData;
+	int		nBytes = nBits >> 3;
+	int		shift = sb->iCurBit & 7;
+	const byte	*pIn;
+	qword		reg;
+
+	if( nBytes < 4 || ( sb->iCurBit + nBits ) > sb->nDataBits )
+		return MSG_ReadBitsGeneric( sb, pOutData, nBits );
+
+	pIn = sb->pData + ( sb->iCurBit >> 3 );
+
+	if( !shift )
+	{
+		memcpy( pOut, pIn, nBytes );
+		pOut += nBytes;
+	}
+	else
+	{
+		int	i = nBytes;
+		int	nRegBits = 8 - shift;
+
+		reg = *pIn++ >> shift;
+
+		for( ; i >= 4; i -= 4, pIn += 4, pOut += 4 )
+		{
+			reg |= (qword)(*(dword *)pIn) << nRegBits;
+			*(dword *)pOut = (dword)reg;
+			reg >>= 32;
+		}
+
+		for( ; i > 0; i--, pIn++, pOut++ )
+		{
+			reg |= (qword)*pIn << nRegBits;
+			*pOut = (byte)reg;
+			reg >>= 8;
+		}
+	}
+
+	sb->iCurBit += nBytes << 3;
+
+	// read the remaining bits.
+	if( nBits & 7 )
+		*pOut = MSG_ReadUBitLong( sb, nBits & 7 );
+
+	return !sb->bOverflow;
+}
+
 float MSG_ReadBitAngle( sizebuf_t *sb, int numbits )
 {
 	float	fReturn, shift;
@@ -649,4 +762,117 @@ void MSG_ExciseBits( sizebuf_t *sb, int startbit, int bitstoremove )
 
 	MSG_SeekToBit( sb, startbit );
 	sb->nDataBits -= bitstoremove;
-}
\ No newline at end of file
+}
+
+/*
+=======================
+MSG_Benchmark_f
+
+measure bit-stream throughput on typical workloads
+and check fast paths against the piecewise copy
+=======================
+*/
+#define BENCH_MSG_BYTES	1400
+#define BENCH_CLIENTS	32
+
+void MSG_Benchmark_f( void )
+{
+	static dword	src[BENCH_MSG_BYTES / 4];
+	static dword	out1[512], out2[512];
+	int		i, j, k, nBits, iterations;
+	sizebuf_t		msg1, msg2;
+	double		start, fast, generic;
+	int		errors = 0;
+
+	iterations = ( Cmd_Argc() > 1 ) ? Q_max( 1, Q_atoi( Cmd_Argv( 1 ))) : 1000;
+
+	for( i = 0; i < BENCH_MSG_BYTES; i++ )
+		((byte *)src)[i] = COM_RandomLong( 0, 255 );
+
+	// delta encoding: lot of small fields at random offsets
+	start = Sys_DoubleTime();
+	for( i = 0; i < iterations; i++ )
+	{
+		MSG_Init( &msg1, "Bench", out1, sizeof( out1 ));
+
+		for( j = 0; MSG_GetNumBitsLeft( &msg1 ) >= 66; j++ )
+		{
+			MSG_WriteOneBit( &msg1, j & 1 );
+			MSG_WriteUBitLong( &msg1, j, 11 );
+			MSG_WriteSBitLong( &msg1, -j, 19 );
+			MSG_WriteUBitLong( &msg1, src[j & 255], 32 );
+			MSG_WriteUBitLong( &msg1, j, 3 );
+		}
+
+		MSG_StartReading( &msg1, out1, sizeof( out1 ), 0, MSG_GetNumBitsWritten( &msg1 ));
+
+		for( j = 0; MSG_GetNumBitsLeft( &msg1 ) >= 66; j++ )
+		{
+			if( MSG_ReadOneBit( &msg1 ) != ( j & 1 )) errors++;
+			if( MSG_ReadUBitLong( &msg1, 11 ) != ( j & 2047 )) errors++;
+			if( MSG_ReadSBitLong( &msg1, 19 ) != -j ) errors++;
+			if( MSG_ReadUBitLong( &msg1, 32 ) != src[j & 255] ) errors++;
+			if( MSG_ReadUBitLong( &msg1, 3 ) != ( j & 7 )) errors++;
+		}
+	}
+	fast = Sys_DoubleTime() - start;
+	Msg( "delta fields: %i messages of %i bytes written and read in %.2f ms\n", iterations, (int)sizeof( out1 ), fast * 1000.0 );
+
+	// multicast: same message copied into every client buffer
+	nBits = BENCH_MSG_BYTES * 8 - 3;
+
+	start = Sys_DoubleTime();
+	for( i = 0; i < iterations; i++ )
+	{
+		for( j = 0; j < BENCH_CLIENTS; j++ )
+		{
+			MSG_Init( &msg1, "Fast", out1, sizeof( out1 ));
+			MSG_WriteUBitLong( &msg1, j, j ); // client buffer is already filled up to some bit
+			MSG_WriteBits( &msg1, src, nBits );
+			MSG_StartReading( &msg1, out1, sizeof( out1 ), j, -1 );
+			MSG_ReadBits( &msg1, out2, nBits );
+		}
+	}
+	fast = Sys_DoubleTime() - start;
+
+	start = Sys_DoubleTime();
+	for( i = 0; i < iterations; i++ )
+	{
+		for( j = 0; j < BENCH_CLIENTS; j++ )
+		{
+			MSG_Init( &msg1, "Generic", out1, sizeof( out1 ));
+			MSG_WriteUBitLong( &msg1, j, j );
+			MSG_WriteBitsGeneric( &msg1, src, nBits );
+			MSG_StartReading( &msg1, out1, sizeof( out1 ), j, -1 );
+			MSG_ReadBitsGeneric( &msg1, out2, nBits );
+		}
+	}
+	generic = Sys_DoubleTime() - start;
+
+	Msg( "multicast copy: %i x %i clients, %.2f ms (piecewise %.2f ms)\n", iterations, BENCH_CLIENTS, fast * 1000.0, generic * 1000.0 );
+
+	// fast paths must produce the same bits as piecewise copy
+	for( j = 0; j < BENCH_CLIENTS; j++ )
+	{
+		memset( out1, 0xAA, sizeof( out1 ));
+		memset( out2, 0xAA, sizeof( out2 ));
+		MSG_Init( &msg1, "Fast", out1, sizeof( out1 ));
+		MSG_Init( &msg2, "Generic", out2, sizeof( out2 ));
+		MSG_WriteUBitLong( &msg1, j, j );
+		MSG_WriteUBitLong( &msg2, j, j );
+		MSG_WriteBits( &msg1, src, nBits );
+		MSG_WriteBitsGeneric( &msg2, src, nBits );
+
+		MSG_StartReading( &msg1, out1, sizeof( out1 ), 0, MSG_GetNumBitsWritten( &msg1 ));
+		MSG_StartReading( &msg2, out2, sizeof( out2 ), 0, MSG_GetNumBitsWritten( &msg2 ));
+
+		for( k = MSG_GetNumBitsLeft( &msg1 ); k > 0; k -= 32 )
+		{
+			if( MSG_ReadUBitLong( &msg1, Q_min( k, 32 )) != MSG_ReadUBitLong( &msg2, Q_min( k, 32 )))
+				errors++;
+		}
+	}
+
+	if( errors ) Msg( "^1bit-stream check failed: %i mismatches\n", errors );
+	else Msg( "bit-stream check passed\n" );
+}
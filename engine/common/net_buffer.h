@@ -63,6 +63,7 @@ void MSG_SeekToByte( sizebuf_t *sb, int bytePos );
 void MSG_ExciseBits( sizebuf_t *sb, int startbit, int bitstoremove );
 qboolean MSG_CheckOverflow( sizebuf_t *sb );
 short MSG_BigShort( short swap );
+void MSG_Benchmark_f( void );
 
 // init writing
 void MSG_StartWriting( sizebuf_t *sb, void *pData, int nBytes, int iStartBit, int nBits );
@@ -28,10 +28,54 @@ GNU General Public License for more details.
 #define FLOW_AVG			( 2.0 / 3.0 )	// how fast to converge flow estimates
 #define FLOW_INTERVAL		0.1		// don't compute more often than this    
 #define MAX_RELIABLE_PAYLOAD		1200		// biggest packet that has frag and or reliable data
+#define MIN_COMPRESS_SIZE		64		// don't waste time for small fragments
+
+// stream state in packet header
+#define FRAG_NOT_SENT		0
+#define FRAG_SENT			1
+#define FRAG_SENT_COMPRESSED		2		// fragment data is LZSS block, never sent to old clients
 
 // forward declarations
 void Netchan_FlushIncoming( netchan_t *chan, int stream );
 void Netchan_AddBufferToList( fragbuf_t **pplist, fragbuf_t *pbuf );
+static void Netchan_ReleaseFileCache( fragbuf_t *buf );
+static void Netchan_DownloadCacheInfo_f( void );
+
+// single fragment of cached file
+typedef struct
+{
+	int		offset;		// in netfile_t->data
+	int		size;
+	int		zoffset;		// in netfile_t->zdata
+	int		zsize;		// 0 if fragment can't be compressed
+} netfrag_t;
+
+// file downloads cache, file is read and splitted only once for all
+// clients that are use the same fragment size (cl_dlmax)
+typedef struct netfile_s
+{
+	struct netfile_s	*next;
+	char		filename[MAX_OSPATH];
+	long		filetime;		// to catch modified files
+	int		chunksize;
+	int		refcount;		// number of queued fragbufs that points to this file
+	double		lastused;
+	size_t		memsize;
+
+	byte		*data;		// filename and file contents, just like they sent
+	int		size;
+	byte		*zdata;		// compressed fragments
+	netfrag_t		*frags;
+	int		numfrags;
+} netfile_t;
+
+static struct
+{
+	netfile_t		*files;
+	size_t		memsize;
+	int		hits;
+	int		misses;
+} net_filecache;
 
 /*
 packet header ( size in bits )
@@ -89,12 +133,15 @@ convar_t	*net_chokeloopback;
 convar_t	*net_showdrop;
 convar_t	*net_speeds;
 convar_t	*net_qport;
+convar_t	*net_compress;
+convar_t	*net_dlcache_size;
 
 int	net_drop;
 netadr_t	net_from;
 sizebuf_t	net_message;
 byte	*net_mempool;
 byte	net_message_buffer[NET_MAX_PAYLOAD];
+static byte	net_lzss_buffer[NET_MAX_PAYLOAD];	// scratch for fragment compression
 
 /*
 ===============
@@ -113,15 +160,23 @@ void Netchan_Init( void )
 	net_showdrop = Cvar_Get( "net_showdrop", "0", 0, "show packets that are dropped" );
 	net_speeds = Cvar_Get( "net_speeds", "0", FCVAR_ARCHIVE, "show network packets" );
 	net_qport = Cvar_Get( "net_qport", va( "%i", port ), FCVAR_READ_ONLY, "current quake netport" );
+	net_compress = Cvar_Get( "net_compress", "1", FCVAR_ARCHIVE, "compress outgoing fragments if remote side supports it (2 - also on loopback)" );
+	net_dlcache_size = Cvar_Get( "net_dlcache_size", "64", FCVAR_ARCHIVE, "memory for shared file downloads cache in megabytes, 0 - read files for each client" );
 
 	net_mempool = Mem_AllocPool( "Network Pool" );
 
 	MSG_InitMasks ();	// initialize bit-masks
+
+	Cmd_AddCommand( "msg_benchmark", MSG_Benchmark_f, "measure network message reading and writing speed" );
+	Cmd_AddCommand( "net_dlcache_info", Netchan_DownloadCacheInfo_f, "show files in downloads cache" );
 }
 
 void Netchan_Shutdown( void )
 {
 	Mem_FreePool( &net_mempool );
+
+	// all files was freed with pool
+	memset( &net_filecache, 0, sizeof( net_filecache ));
 }
 
 void Netchan_ReportFlow( netchan_t *chan )
@@ -138,6 +193,17 @@ void Netchan_ReportFlow( netchan_t *chan )
 	Q_strcpy( outgoing, Q_pretifymem((float)chan->flow[FLOW_OUTGOING].totalbytes, 3 ));
 
 	MsgDev( D_INFO, "Signon network traffic:  %s from server, %s to server\n", incoming, outgoing );
+
+	if( chan->total_uncompressed )
+	{
+		MsgDev( D_INFO, "Compressed fragments:  %s to %s (%.1f%%), %.2f msec\n", Q_memprint( chan->total_uncompressed ),
+			Q_memprint( chan->total_compressed ), chan->total_compressed * 100.0f / chan->total_uncompressed, chan->compress_time * 1000.0 );
+	}
+
+	if( chan->total_decompressed )
+	{
+		MsgDev( D_INFO, "Decompressed fragments:  %s, %.2f msec\n", Q_memprint( chan->total_decompressed ), chan->decompress_time * 1000.0 );
+	}
 }
 
 /*
@@ -242,6 +308,7 @@ void Netchan_UnlinkFragment( fragbuf_t *buf, fragbuf_t **list )
 		*list = buf->next;
 		
 		// destroy remnant
+		Netchan_ReleaseFileCache( buf );
 		Mem_Free( buf );
 		return;
 	}
@@ -254,6 +321,7 @@ void Netchan_UnlinkFragment( fragbuf_t *buf, fragbuf_t **list )
 			search->next = buf->next;
 
 			// destroy remnant
+			Netchan_ReleaseFileCache( buf );
 			Mem_Free( buf );
 			return;
 		}
@@ -280,6 +348,7 @@ void Netchan_ClearFragbufs( fragbuf_t **ppbuf )
 	while( buf )
 	{
 		n = buf->next;
+		Netchan_ReleaseFileCache( buf );
 		Mem_Free( buf );
 		buf = n;
 	}
@@ -792,6 +861,301 @@ void Netchan_CreateFileFragmentsFromBuffer( netchan_t *chan, char *filename, byt
 	}
 }
 
+/*
+==============================
+Netchan_FreeFileCache
+
+==============================
+*/
+static void Netchan_FreeFileCache( netfile_t *file )
+{
+	netfile_t	**prev;
+
+	for( prev = &net_filecache.files; *prev; prev = &(*prev)->next )
+	{
+		if( *prev != file ) continue;
+		*prev = file->next;
+		break;
+	}
+
+	net_filecache.memsize -= file->memsize;
+
+	if( file->zdata ) Mem_Free( file->zdata );
+	Mem_Free( file->frags );
+	Mem_Free( file->data );
+	Mem_Free( file );
+}
+
+/*
+==============================
+Netchan_EvictFileCache
+
+free least recently used files that nobody downloads now
+==============================
+*/
+static qboolean Netchan_EvictFileCache( size_t memsize, size_t budget )
+{
+	netfile_t	*file, *oldest;
+
+	while( net_filecache.memsize + memsize > budget )
+	{
+		oldest = NULL;
+
+		for( file = net_filecache.files; file; file = file->next )
+		{
+			if( !file->refcount && ( !oldest || file->lastused < oldest->lastused ))
+				oldest = file;
+		}
+
+		// all the files are downloading right now
+		if( !oldest ) return false;
+
+		MsgDev( D_NOTE, "Netchan_EvictFileCache: %s\n", oldest->filename );
+		Netchan_FreeFileCache( oldest );
+	}
+
+	return true;
+}
+
+/*
+==============================
+Netchan_FindFileCache
+
+==============================
+*/
+static netfile_t *Netchan_FindFileCache( const char *filename, int chunksize )
+{
+	long	filetime = FS_FileTime( filename, false );
+	netfile_t	*file, *next;
+
+	for( file = net_filecache.files; file; file = next )
+	{
+		next = file->next;
+
+		if( file->chunksize != chunksize || Q_stricmp( file->filename, filename ))
+			continue;
+
+		if( file->filetime == filetime )
+			return file;
+
+		// file was changed on disk, old copy is
+		// still used by clients which downloads it
+		if( !file->refcount ) Netchan_FreeFileCache( file );
+	}
+
+	return NULL;
+}
+
+/*
+==============================
+Netchan_LoadFileCache
+
+read the file and split it to fragments the same
+way as Netchan_CreateFileFragments does
+==============================
+*/
+static netfile_t *Netchan_LoadFileCache( const char *filename, int chunksize )
+{
+	size_t	budget = (size_t)( net_dlcache_size->value * 1024.0f * 1024.0f );
+	int	namelen = Q_strlen( filename ) + 1;
+	int	filesize = FS_FileSize( filename, false );
+	int	i, size, numfrags, zsize = 0;
+	size_t	memsize;
+	netfile_t	*file;
+	file_t	*f;
+
+	if( filesize <= 0 || chunksize <= 0 )
+		return NULL;
+
+	// first fragment begins with filename
+	size = namelen + filesize;
+	numfrags = ( size + chunksize - 1 ) / chunksize;
+
+	// compressed data is never bigger than raw
+	memsize = sizeof( netfile_t ) + numfrags * sizeof( netfrag_t ) + size * 2;
+
+	if( memsize > budget || !Netchan_EvictFileCache( memsize, budget ))
+		return NULL;
+
+	f = FS_Open( filename, "rb", false );
+	if( !f ) return NULL;
+
+	file = (netfile_t *)Mem_Alloc( net_mempool, sizeof( netfile_t ));
+	file->data = (byte *)Mem_Alloc( net_mempool, size );
+	memcpy( file->data, filename, namelen );
+
+	if( FS_Read( f, file->data + namelen, filesize ) != filesize )
+	{
+		MsgDev( D_ERROR, "Netchan_LoadFileCache: couldn't read %s\n", filename );
+		Mem_Free( file->data );
+		Mem_Free( file );
+		FS_Close( f );
+		return NULL;
+	}
+
+	FS_Close( f );
+
+	Q_strncpy( file->filename, filename, sizeof( file->filename ));
+	file->filetime = FS_FileTime( filename, false );
+	file->chunksize = chunksize;
+	file->size = size;
+	file->frags = (netfrag_t *)Mem_Alloc( net_mempool, numfrags * sizeof( netfrag_t ));
+	file->numfrags = numfrags;
+
+	if( net_compress->value != 0.0f )
+		file->zdata = (byte *)Mem_Alloc( net_mempool, size );
+
+	for( i = 0; i < numfrags; i++ )
+	{
+		netfrag_t	*frag = &file->frags[i];
+		int	numbits, len;
+
+		frag->offset = i * chunksize;
+		frag->size = Q_min( chunksize, size - frag->offset );
+
+		if( !file->zdata || frag->size < MIN_COMPRESS_SIZE )
+			continue;
+
+		// the same layout as in Netchan_CompressFragment
+		len = LZSS_Compress( file->data + frag->offset, frag->size, file->zdata + zsize + 4, frag->size - 4 );
+		if( !len ) continue;
+
+		numbits = frag->size << 3;
+		memcpy( file->zdata + zsize, &numbits, 4 );
+		frag->zoffset = zsize;
+		frag->zsize = len + 4;
+		zsize += frag->zsize;
+	}
+
+	if( file->zdata && !zsize )
+	{
+		Mem_Free( file->zdata );
+		file->zdata = NULL;
+	}
+	else if( file->zdata )
+	{
+		file->zdata = (byte *)Mem_Realloc( net_mempool, file->zdata, zsize );
+	}
+
+	file->memsize = sizeof( netfile_t ) + numfrags * sizeof( netfrag_t ) + size + zsize;
+	net_filecache.memsize += file->memsize;
+
+	file->next = net_filecache.files;
+	net_filecache.files = file;
+
+	MsgDev( D_NOTE, "Netchan_LoadFileCache: %s, %i fragments, %s\n", filename, numfrags, Q_memprint( file->memsize ));
+
+	return file;
+}
+
+/*
+==============================
+Netchan_ReleaseFileCache
+
+fragment was sent or thrown away
+==============================
+*/
+static void Netchan_ReleaseFileCache( fragbuf_t *buf )
+{
+	if( !buf->filecache )
+		return;
+
+	buf->filecache->refcount--;
+	buf->filecache = NULL;
+}
+
+/*
+==============================
+Netchan_CreateCachedFileFragments
+
+queue fragments that are shared with other clients
+==============================
+*/
+static qboolean Netchan_CreateCachedFileFragments( netchan_t *chan, const char *filename, int chunksize )
+{
+	fragbufwaiting_t	*wait, *p;
+	netfile_t		*file;
+	fragbuf_t		*buf;
+	int		i;
+
+	if( net_dlcache_size->value <= 0.0f )
+		return false;
+
+	file = Netchan_FindFileCache( filename, chunksize );
+
+	if( !file )
+	{
+		file = Netchan_LoadFileCache( filename, chunksize );
+		if( !file ) return false;
+		net_filecache.misses++;
+	}
+	else net_filecache.hits++;
+
+	file->lastused = host.realtime;
+
+	wait = (fragbufwaiting_t *)Mem_Alloc( net_mempool, sizeof( fragbufwaiting_t ));
+
+	for( i = 0; i < file->numfrags; i++ )
+	{
+		buf = Netchan_AllocFragbuf();
+		buf->bufferid = i + 1;
+
+		buf->isfile = true;
+		buf->size = file->frags[i].size;
+		buf->foffset = file->frags[i].offset;
+		Q_strncpy( buf->filename, filename, sizeof( buf->filename ));
+
+		buf->filecache = file;
+		buf->filefrag = i;
+		file->refcount++;
+
+		Netchan_AddFragbufToTail( wait, buf );
+	}
+
+	// now add waiting list item to end of buffer queue
+	if( !chan->waitlist[FRAG_FILE_STREAM] )
+	{
+		chan->waitlist[FRAG_FILE_STREAM] = wait;
+	}
+	else
+	{
+		p = chan->waitlist[FRAG_FILE_STREAM];
+
+		while( p->next )
+			p = p->next;
+		p->next = wait;
+	}
+
+	return true;
+}
+
+/*
+==============================
+Netchan_DownloadCacheInfo_f
+
+==============================
+*/
+static void Netchan_DownloadCacheInfo_f( void )
+{
+	netfile_t	*file;
+	int	count = 0;
+
+	Msg( "%-40s %6s %10s %10s %5s\n", "file", "frags", "size", "packed", "refs" );
+
+	for( file = net_filecache.files; file; file = file->next, count++ )
+	{
+		int	i, packed = 0;
+
+		for( i = 0; i < file->numfrags; i++ )
+			packed += file->frags[i].zsize ? file->frags[i].zsize : file->frags[i].size;
+
+		Msg( "%-40s %6i %10s %10s %5i\n", file->filename, file->numfrags, Q_memprint( file->size ), Q_memprint( packed ), file->refcount );
+	}
+
+	Msg( "%i files, %s of %s Mb, %i hits, %i misses\n", count, Q_memprint( net_filecache.memsize ),
+		net_dlcache_size->string, net_filecache.hits, net_filecache.misses );
+}
+
 /*
 ==============================
 Netchan_CreateFileFragments
@@ -812,6 +1176,11 @@ int Netchan_CreateFileFragments( netchan_t *chan, const char *filename )
 	if( chan->pfnBlockSize != NULL )
 		chunksize = chan->pfnBlockSize( chan->client );
 	else chunksize = (FRAGMENT_MAX_SIZE >> 1);
+
+	// share file with other clients
+	if( Netchan_CreateCachedFileFragments( chan, filename, chunksize ))
+		return 1;
+
 	filesize = FS_FileSize( filename, false );
 
 	if( filesize <= 0 )
@@ -1190,6 +1559,126 @@ void Netchan_UpdateProgress( netchan_t *chan )
 	Cvar_SetValue( "scr_download", bestpercent );
 }
 
+/*
+==============================
+Netchan_CanCompress
+
+==============================
+*/
+static qboolean Netchan_CanCompress( netchan_t *chan )
+{
+	if( !chan->compress || net_compress->value == 0.0f )
+		return false;
+
+	if( Netchan_IsLocal( chan ) && net_compress->value < 2.0f )
+		return false;
+
+	return true;
+}
+
+/*
+==============================
+Netchan_CompressFragment
+
+replace fragment data with compressed block:
+long with uncompressed size in bits and LZSS data
+==============================
+*/
+static qboolean Netchan_CompressFragment( netchan_t *chan, fragbuf_t *pbuf )
+{
+	int	numbits = MSG_GetNumBitsWritten( &pbuf->frag_message );
+	int	numbytes = MSG_GetNumBytesWritten( &pbuf->frag_message );
+	double	start;
+	int	size;
+
+	if( numbytes < MIN_COMPRESS_SIZE || !Netchan_CanCompress( chan ))
+		return false;
+
+	start = Sys_DoubleTime();
+	size = LZSS_Compress( MSG_GetData( &pbuf->frag_message ), numbytes, net_lzss_buffer, numbytes - 4 );
+	chan->compress_time += Sys_DoubleTime() - start;
+
+	chan->total_uncompressed += numbytes;
+
+	if( !size )
+	{
+		// incompressible data (e.g. already compressed files)
+		chan->total_compressed += numbytes;
+		return false;
+	}
+
+	chan->total_compressed += size + 4;
+
+	MSG_Clear( &pbuf->frag_message );
+	MSG_WriteLong( &pbuf->frag_message, numbits );
+	MSG_WriteBits( &pbuf->frag_message, net_lzss_buffer, size << 3 );
+
+	return true;
+}
+
+/*
+==============================
+Netchan_CopyCachedFragment
+
+copy compressed or raw fragment from downloads cache
+==============================
+*/
+static qboolean Netchan_CopyCachedFragment( netchan_t *chan, fragbuf_t *pbuf )
+{
+	netfile_t	*file = pbuf->filecache;
+	netfrag_t	*frag = &file->frags[pbuf->filefrag];
+
+	MSG_Clear( &pbuf->frag_message );
+
+	if( frag->zsize && Netchan_CanCompress( chan ))
+	{
+		MSG_WriteBits( &pbuf->frag_message, file->zdata + frag->zoffset, frag->zsize << 3 );
+		chan->total_uncompressed += frag->size;
+		chan->total_compressed += frag->zsize;
+		return true;
+	}
+
+	MSG_WriteBits( &pbuf->frag_message, file->data + frag->offset, frag->size << 3 );
+
+	return false;
+}
+
+/*
+==============================
+Netchan_DecompressFragment
+
+==============================
+*/
+static qboolean Netchan_DecompressFragment( netchan_t *chan, fragbuf_t *pbuf, byte *data, int bits )
+{
+	int	numbytes = BitByte( bits );
+	int	maxsize = FRAGMENT_MAX_SIZE;
+	double	start;
+	int	numbits;
+	int	size;
+
+	if( numbytes <= 4 )
+		return false;
+
+	// same limits as in Netchan_Validate
+	if( Netchan_IsLocal( chan ))
+		maxsize = NET_MAX_PAYLOAD;
+
+	numbits = *(int *)data;
+
+	start = Sys_DoubleTime();
+	size = LZSS_Decompress( data + 4, numbytes - 4, net_lzss_buffer, maxsize );
+	chan->decompress_time += Sys_DoubleTime() - start;
+
+	if( size < 0 || numbits <= 0 || BitByte( numbits ) != size )
+		return false;
+
+	MSG_WriteBits( &pbuf->frag_message, net_lzss_buffer, numbits );
+	chan->total_decompressed += size;
+
+	return true;
+}
+
 /*
 ===============
 Netchan_TransmitBits
@@ -1287,6 +1776,7 @@ void Netchan_TransmitBits( netchan_t *chan, int length, byte *data )
 
 			// assume no fragment is being sent
 			chan->reliable_fragment[i] = 0;
+			chan->frag_compressed[i] = false;
 			chan->reliable_fragid[i] = 0;
 			chan->frag_length[i] = 0;
 
@@ -1340,18 +1830,28 @@ void Netchan_TransmitBits( netchan_t *chan, int length, byte *data )
 				// which buffer are we sending ?
 				chan->reliable_fragid[i] = MAKE_FRAGID( pbuf->bufferid, chan->fragbufcount[i] );
 			
-				// if it's not in-memory, then we'll need to copy it in frame the file handle.
-				if( pbuf->isfile && !pbuf->isbuffer )
+				if( pbuf->filecache )
 				{
-					byte	filebuffer[NET_MAX_PAYLOAD];
-					file_t	*file;
+					// file was already splitted and compressed
+					chan->frag_compressed[i] = Netchan_CopyCachedFragment( chan, pbuf );
+				}
+				else
+				{
+					// if it's not in-memory, then we'll need to copy it in frame the file handle.
+					if( pbuf->isfile && !pbuf->isbuffer )
+					{
+						byte	filebuffer[NET_MAX_PAYLOAD];
+						file_t	*file;
+
+						file = FS_Open( pbuf->filename, "rb", false );
+						FS_Seek( file, pbuf->foffset, SEEK_SET );
+						FS_Read( file, filebuffer, pbuf->size );
 
-					file = FS_Open( pbuf->filename, "rb", false );
-					FS_Seek( file, pbuf->foffset, SEEK_SET );
-					FS_Read( file, filebuffer, pbuf->size );
+						MSG_WriteBits( &pbuf->frag_message, filebuffer, pbuf->size << 3 );
+						FS_Close( file );
+					}
 
-					MSG_WriteBits( &pbuf->frag_message, filebuffer, pbuf->size << 3 );
-					FS_Close( file );
+					chan->frag_compressed[i] = Netchan_CompressFragment( chan, pbuf );
 				}
 
 				// copy frag stuff on top of current buffer
@@ -1409,14 +1909,14 @@ void Netchan_TransmitBits( netchan_t *chan, int length, byte *data )
 		{
 			if( chan->reliable_fragment[i] )
 			{
-				MSG_WriteByte( &send, 1 );
+				MSG_WriteByte( &send, chan->frag_compressed[i] ? FRAG_SENT_COMPRESSED : FRAG_SENT );
 				MSG_WriteLong( &send, chan->reliable_fragid[i] );
 				MSG_WriteLong( &send, chan->frag_startpos[i] );
 				MSG_WriteLong( &send, chan->frag_length[i] );
 			}
 			else 
 			{
-				MSG_WriteByte( &send, 0 );
+				MSG_WriteByte( &send, FRAG_NOT_SENT );
 			}
 		}
 	}
@@ -1518,6 +2018,7 @@ qboolean Netchan_Process( netchan_t *chan, sizebuf_t *msg )
 	uint	reliable_ack, reliable_message;
 	uint	fragid[MAX_STREAMS] = { 0, 0 };
 	qboolean	frag_message[MAX_STREAMS] = { false, false };
+	qboolean	frag_compressed[MAX_STREAMS] = { false, false };
 	int	frag_offset[MAX_STREAMS] = { 0, 0 };
 	int	frag_length[MAX_STREAMS] = { 0, 0 };
 	qboolean	message_contains_fragments;
@@ -1546,8 +2047,11 @@ qboolean Netchan_Process( netchan_t *chan, sizebuf_t *msg )
 	{
 		for( i = 0; i < MAX_STREAMS; i++ )
 		{
-			if( MSG_ReadByte( msg ))
+			int	state = MSG_ReadByte( msg );
+
+			if( state != FRAG_NOT_SENT )
 			{
+				frag_compressed[i] = ( state == FRAG_SENT_COMPRESSED );
 				frag_message[i] = true;
 				fragid[i] = MSG_ReadLong( msg );
 				frag_offset[i] = MSG_ReadLong( msg );
@@ -1593,6 +2097,50 @@ qboolean Netchan_Process( netchan_t *chan, sizebuf_t *msg )
 		return false;
 	}
 
+	// copy fragments before the packet is acknowledged, so packet with
+	// compressed fragment which can't be unpacked is dropped and resent
+	if( message_contains_fragments )
+	{
+		for( i = 0; i < MAX_STREAMS; i++ )
+		{
+			fragbuf_t	*pbuf;
+			byte	buffer[NET_MAX_PAYLOAD];
+			sizebuf_t	temp;
+
+			if( !frag_message[i] || fragid[i] == 0 )
+				continue;
+
+			pbuf = Netchan_FindBufferById( &chan->incomingbufs[i], fragid[i], true );
+
+			if( !pbuf )
+			{
+				MsgDev( D_ERROR, "Netchan_Process: Couldn't find buffer %i\n", FRAG_GETID( fragid[i] ));
+				continue;
+			}
+
+			// copy in data
+			MSG_Clear( &pbuf->frag_message );
+
+			MSG_StartReading( &temp, msg->pData, MSG_GetMaxBytes( msg ), MSG_GetNumBitsRead( msg ) + frag_offset[i], -1 );
+			MSG_ReadBits( &temp, buffer, frag_length[i] );
+
+			if( !frag_compressed[i] )
+			{
+				MSG_WriteBits( &pbuf->frag_message, buffer, frag_length[i] );
+			}
+			else if( !Netchan_DecompressFragment( chan, pbuf, buffer, frag_length[i] ))
+			{
+				// packet can't be damaged in transit, caller drops the channel
+				// when the resent fragment is still bad
+				MsgDev( D_ERROR, "Netchan_Process: corrupted compressed fragment %i\n", FRAG_GETID( fragid[i] ));
+				MSG_Clear( &pbuf->frag_message );
+				chan->bad_fragments++;
+				return false;
+			}
+			else chan->bad_fragments = 0;
+		}
+	}
+
 	// dropped packets don't keep the message from being used
 	net_drop = sequence - ( chan->incoming_sequence + 1 );
 	if( net_drop > 0 && net_showdrop->value )
@@ -1633,45 +2181,19 @@ qboolean Netchan_Process( netchan_t *chan, sizebuf_t *msg )
 	{
 		for( i = 0; i < MAX_STREAMS; i++ )
 		{
-			fragbuf_t	*pbuf;
-			int	j, inbufferid;
-			int	intotalbuffers;
+			int	j, intotalbuffers;
 			int	oldpos, curbit;
 			int	numbitstoremove;
 
 			if( !frag_message[i] )
 				continue;
 		
-			inbufferid = FRAG_GETID( fragid[i] );
 			intotalbuffers = FRAG_GETCOUNT( fragid[i] );
 
+			// data was copied in already, count # of incoming bufs
+			// we've queued? are we done?
 			if( fragid[i] != 0 )
-			{
-				pbuf = Netchan_FindBufferById( &chan->incomingbufs[i], fragid[i], true );
-
-				if( pbuf )
-				{
-					byte	buffer[NET_MAX_PAYLOAD];
-					sizebuf_t	temp;
-					int	bits;
-
-					bits = frag_length[i];
-				
-					// copy in data
-					MSG_Clear( &pbuf->frag_message );
-
-					MSG_StartReading( &temp, msg->pData, MSG_GetMaxBytes( msg ), MSG_GetNumBitsRead( msg ) + frag_offset[i], -1 );
-					MSG_ReadBits( &temp, buffer, bits );
-					MSG_WriteBits( &pbuf->frag_message, buffer, bits );
-				}
-				else
-				{
-					MsgDev( D_ERROR, "Netchan_Process: Couldn't find buffer %i\n", inbufferid );
-				}
-
-				// count # of incoming bufs we've queued? are we done?
 				Netchan_CheckForCompletion( chan, i, intotalbuffers );
-			}
 
 			// rearrange incoming data to not have the frag stuff in the middle of it
 			oldpos = MSG_GetNumBitsRead( msg );
@@ -23,6 +23,8 @@ GNU General Public License for more details.
 #define MAX_LOOPBACK	4
 #define MASK_LOOPBACK	(MAX_LOOPBACK - 1)
 #define NET_MAX_FRAGMENTS	32
+#define NET_QUEUE_SIZE	256	// packets buffered by server receive thread (power of two)
+#define NET_QUEUE_MASK	(NET_QUEUE_SIZE - 1)
 
 // wsock32.dll exports
 static int (_stdcall *pWSACleanup)( void );
@@ -118,6 +120,29 @@ typedef struct
 } SPLITPACKET;
 #pragma pack(pop)
 
+typedef struct
+{
+	netadr_t		from;
+	int		length;
+	byte		data[MAX_UDP_PACKET];
+} net_queued_t;
+
+// single producer (receive thread), single consumer (server frame)
+typedef struct
+{
+	net_queued_t	packets[NET_QUEUE_SIZE];
+	volatile uint	head;		// advanced by receive thread only
+	volatile uint	tail;		// advanced by NET_QueuePacket only
+} net_queue_t;
+
+typedef struct
+{
+	uint		received;		// total datagrams read from server sockets
+	uint		dropped;		// queue was full
+	uint		batches;		// wakeups of receive thread with some data
+	uint		peak;		// max queue depth
+} net_recvstats_t;
+
 typedef struct
 {
 	net_loopback_t	loopbacks[NS_COUNT];
@@ -131,6 +156,13 @@ typedef struct
 	int		ip_sockets[NS_COUNT];
 	int		ipx_sockets[NS_COUNT];
 
+	// optional server receive thread
+	HANDLE		recv_thread;
+	HANDLE		recv_event;		// signalled when something was queued
+	volatile qboolean	recv_shutdown;
+	net_queue_t	*recv_queue;
+	net_recvstats_t	recv_stats;
+
 	WSADATA		winsockdata;
 	qboolean		initialized;
 	qboolean		noip, noipx;
@@ -944,6 +976,34 @@ qboolean NET_GetLong( byte *pData, int size, int *outSize )
 	}
 }
 
+/*
+==================
+NET_DequeuePacket
+
+fetch packet received by server thread
+==================
+*/
+static int NET_DequeuePacket( netadr_t *from, byte *data )
+{
+	net_queue_t	*queue = net.recv_queue;
+	net_queued_t	*packet;
+	uint		tail = queue->tail;
+	int		length;
+
+	if( queue->head == tail )
+		return SOCKET_ERROR; // empty
+
+	packet = &queue->packets[tail & NET_QUEUE_MASK];
+	*from = packet->from;
+	length = packet->length;
+	memcpy( data, packet->data, length );
+
+	// release slot for receive thread
+	InterlockedExchange( (long *)&queue->tail, tail + 1 );
+
+	return length;
+}
+
 /*
 ==================
 NET_QueuePacket
@@ -962,53 +1022,64 @@ qboolean NET_QueuePacket( netsrc_t sock, netadr_t *from, byte *data, size_t *len
 
 	*length = 0;
 
-	for( protocol = 0; protocol < 2; protocol++ )
+	if( sock == NS_SERVER && net.recv_thread )
 	{
-		if( !protocol) net_socket = net.ip_sockets[sock];
-		else net_socket = net.ipx_sockets[sock];
+		// server sockets are read by receive thread
+		ret = NET_DequeuePacket( from, buf );
+	}
+	else
+	{
+		for( protocol = 0; protocol < 2; protocol++ )
+		{
+			if( !protocol) net_socket = net.ip_sockets[sock];
+			else net_socket = net.ipx_sockets[sock];
 
-		if( net_socket == INVALID_SOCKET )
-			continue;
+			if( net_socket == INVALID_SOCKET )
+				continue;
 
-		addr_len = sizeof( addr );
-		ret = pRecvFrom( net_socket, buf, sizeof( buf ), 0, (struct sockaddr *)&addr, &addr_len );
+			addr_len = sizeof( addr );
+			ret = pRecvFrom( net_socket, buf, sizeof( buf ), 0, (struct sockaddr *)&addr, &addr_len );
 
-		NET_SockadrToNetadr( &addr, from );
+			NET_SockadrToNetadr( &addr, from );
 
-		if( ret == SOCKET_ERROR )
-		{
-			int	err = pWSAGetLastError();
+			if( ret == SOCKET_ERROR )
+			{
+				int	err = pWSAGetLastError();
 
-			if( err == WSAENETRESET )
-				continue;
+				if( err == WSAENETRESET )
+					continue;
 
-			if( err != WSAEWOULDBLOCK && err != WSAECONNRESET && err != WSAECONNREFUSED )
-			{
-				if( err == WSAEMSGSIZE )
+				if( err != WSAEWOULDBLOCK && err != WSAECONNRESET && err != WSAECONNREFUSED )
 				{
-					MsgDev( D_REPORT, "NET_QueuePacket: Ignoring oversized network message\n" );
+					if( err == WSAEMSGSIZE )
+					{
+						MsgDev( D_REPORT, "NET_QueuePacket: Ignoring oversized network message\n" );
+					}
+					else
+					{
+						if( host.type != HOST_DEDICATED )
+							Sys_Error( "NET_QueuePacket: %s from %s\n", NET_ErrorString(), NET_AdrToString( *from ));
+						else MsgDev( D_ERROR, "NET_QueuePacket: %s from %s\n", NET_ErrorString(), NET_AdrToString( *from ));
+					}
 				}
-				else
-				{
-					if( host.type != HOST_DEDICATED )
-						Sys_Error( "NET_QueuePacket: %s from %s\n", NET_ErrorString(), NET_AdrToString( *from ));
-					else MsgDev( D_ERROR, "NET_QueuePacket: %s from %s\n", NET_ErrorString(), NET_AdrToString( *from ));
-				}
-			}
 
-			continue;
-		}
+				continue;
+			}
 
 
-		if( ret != MAX_UDP_PACKET )
-			break;
+			if( ret != MAX_UDP_PACKET )
+				break;
 
-		MsgDev( D_REPORT, "NET_QueuePacket: oversize packet from %s\n", NET_AdrToString( *from ));
+			MsgDev( D_REPORT, "NET_QueuePacket: oversize packet from %s\n", NET_AdrToString( *from ));
+		}
 	}
 
 	if( ret == SOCKET_ERROR || ret == MAX_UDP_PACKET )
 		return NET_LagPacket( false, sock, from, length, data );
 
+	if( sock == NS_SERVER && !net.recv_thread )
+		net.recv_stats.received++;
+
 	memcpy( data, buf, ret );
 	*length = ret;
 
@@ -1490,6 +1561,269 @@ void NET_GetLocalAddress( void )
 	}
 }
 
+/*
+====================
+NET_RecvBatch
+
+read everything server sockets have,
+called from receive thread
+====================
+*/
+static int NET_RecvBatch( void )
+{
+	net_queue_t	*queue = net.recv_queue;
+	byte		scratch[MAX_UDP_PACKET];
+	struct sockaddr	addr;
+	int		addr_len, ret;
+	int		protocol, count = 0;
+	net_queued_t	*packet;
+	SOCKET		net_socket;
+	uint		head, depth;
+	byte		*buf;
+
+	for( protocol = 0; protocol < 2; protocol++ )
+	{
+		if( !protocol) net_socket = net.ip_sockets[NS_SERVER];
+		else net_socket = net.ipx_sockets[NS_SERVER];
+
+		if( net_socket == INVALID_SOCKET )
+			continue;
+
+		while( 1 )
+		{
+			head = queue->head;
+			depth = head - queue->tail;
+			packet = &queue->packets[head & NET_QUEUE_MASK];
+
+			// if queue is full just drain the socket
+			buf = ( depth < NET_QUEUE_SIZE ) ? packet->data : scratch;
+
+			addr_len = sizeof( addr );
+			ret = pRecvFrom( net_socket, buf, MAX_UDP_PACKET, 0, (struct sockaddr *)&addr, &addr_len );
+
+			if( ret == SOCKET_ERROR )
+			{
+				// WSAEWOULDBLOCK is the end of the batch, other errors
+				// are reported by NET_QueuePacket in non-threaded mode
+				if( pWSAGetLastError() == WSAECONNRESET )
+					continue;
+				break;
+			}
+
+			net.recv_stats.received++;
+
+			if( ret == MAX_UDP_PACKET )
+				continue; // oversized
+
+			if( buf == scratch )
+			{
+				net.recv_stats.dropped++;
+				continue;
+			}
+
+			NET_SockadrToNetadr( &addr, &packet->from );
+			packet->length = ret;
+
+			// publish packet for server frame
+			InterlockedExchange( (long *)&queue->head, head + 1 );
+			net.recv_stats.peak = Q_max( net.recv_stats.peak, depth + 1 );
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/*
+====================
+NET_RecvThread
+
+wait for server packets and queue them
+====================
+*/
+static DWORD WINAPI NET_RecvThread( void *unused )
+{
+	struct timeval	timeout;
+	fd_set		fdset;
+	int		maxfd;
+
+	while( !net.recv_shutdown )
+	{
+		FD_ZERO( &fdset );
+		maxfd = 0;
+
+		if( net.ip_sockets[NS_SERVER] != INVALID_SOCKET )
+		{
+			FD_SET( net.ip_sockets[NS_SERVER], &fdset );
+			maxfd = net.ip_sockets[NS_SERVER];
+		}
+
+		if( net.ipx_sockets[NS_SERVER] != INVALID_SOCKET )
+		{
+			FD_SET( net.ipx_sockets[NS_SERVER], &fdset );
+			maxfd = Q_max( maxfd, net.ipx_sockets[NS_SERVER] );
+		}
+
+		// timeout is needed to check for shutdown
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 50000;
+
+		if( pSelect( maxfd + 1, &fdset, NULL, NULL, &timeout ) <= 0 )
+			continue;
+
+		if( NET_RecvBatch( ))
+		{
+			net.recv_stats.batches++;
+			SetEvent( net.recv_event );
+		}
+	}
+
+	return 0;
+}
+
+/*
+====================
+NET_StartRecvThread
+====================
+*/
+static void NET_StartRecvThread( void )
+{
+	DWORD	id;
+
+	if( net.recv_thread || !Sys_CheckParm( "-netthread" ))
+		return;
+
+	if( net.ip_sockets[NS_SERVER] == INVALID_SOCKET && net.ipx_sockets[NS_SERVER] == INVALID_SOCKET )
+		return;
+
+	net.recv_queue = Mem_Alloc( host.mempool, sizeof( net_queue_t ));
+	net.recv_event = CreateEvent( NULL, FALSE, FALSE, NULL );
+	net.recv_shutdown = false;
+
+	if( net.recv_event )
+		net.recv_thread = CreateThread( NULL, 0, NET_RecvThread, NULL, 0, &id );
+
+	if( !net.recv_thread )
+	{
+		MsgDev( D_ERROR, "NET_StartRecvThread: couldn't create network thread\n" );
+		if( net.recv_event ) CloseHandle( net.recv_event );
+		Mem_Free( net.recv_queue );
+		net.recv_queue = NULL;
+		net.recv_event = NULL;
+		return;
+	}
+
+	MsgDev( D_INFO, "Server packets received by network thread\n" );
+}
+
+/*
+====================
+NET_StopRecvThread
+
+must be called before server sockets are closed
+====================
+*/
+static void NET_StopRecvThread( void )
+{
+	if( !net.recv_thread )
+		return;
+
+	net.recv_shutdown = true;
+	WaitForSingleObject( net.recv_thread, INFINITE );
+	CloseHandle( net.recv_thread );
+	CloseHandle( net.recv_event );
+	Mem_Free( net.recv_queue );
+
+	net.recv_thread = NULL;
+	net.recv_event = NULL;
+	net.recv_queue = NULL;
+}
+
+/*
+====================
+NET_RecvStats_f
+====================
+*/
+static void NET_RecvStats_f( void )
+{
+	net_recvstats_t	*stats = &net.recv_stats;
+
+	Msg( "server receive: %s\n", net.recv_thread ? "network thread" : "server frame" );
+	Msg( "%i packets received, %i dropped by full queue\n", stats->received, stats->dropped );
+
+	if( net.recv_thread )
+	{
+		Msg( "%i batches, %.1f packets per batch, peak queue %i of %i\n", stats->batches,
+			stats->batches ? (float)stats->received / stats->batches : 0.0f, stats->peak, NET_QUEUE_SIZE );
+	}
+
+	if( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ))
+		memset( stats, 0, sizeof( *stats ));
+}
+
+/*
+====================
+NET_LoadTest_f
+
+flood our own server socket with game packets from
+many fake clients to measure receive path throughput
+====================
+*/
+static void NET_LoadTest_f( void )
+{
+	int		i, numpackets, numclients;
+	int		net_socket, addr_len, sent = 0;
+	byte		packet[128];
+	struct sockaddr	addr;
+	double		start;
+
+	if( Cmd_Argc() < 2 )
+	{
+		Msg( "Usage: net_loadtest <packets> [clients]\n" );
+		return;
+	}
+
+	if( net.ip_sockets[NS_SERVER] == INVALID_SOCKET )
+	{
+		Msg( "net_loadtest: server IP socket is not opened\n" );
+		return;
+	}
+
+	numpackets = bound( 1, Q_atoi( Cmd_Argv( 1 )), 1000000 );
+	numclients = ( Cmd_Argc() > 2 ) ? bound( 1, Q_atoi( Cmd_Argv( 2 )), 65535 ) : 32;
+
+	addr_len = sizeof( addr );
+	if( pGetSockName( net.ip_sockets[NS_SERVER], &addr, &addr_len ) == SOCKET_ERROR )
+	{
+		Msg( "net_loadtest: %s\n", NET_ErrorString( ));
+		return;
+	}
+	((struct sockaddr_in *)&addr)->sin_addr.s_addr = pInet_Addr( "127.0.0.1" );
+
+	// send from another port, so server can't mix it with real clients
+	net_socket = NET_IPSocket( "localhost", PORT_ANY, false );
+	if( net_socket == INVALID_SOCKET ) return;
+
+	memset( packet, 0, sizeof( packet ));
+	start = Sys_DoubleTime();
+
+	for( i = 0; i < numpackets; i++ )
+	{
+		// sequenced packet header: sequence, acknowledge, qport
+		((int *)packet)[0] = i;
+		((int *)packet)[1] = i;
+		((word *)packet)[4] = 0xF000 + ( i % numclients );
+
+		if( pSendTo( net_socket, packet, sizeof( packet ), 0, &addr, sizeof( addr )) != SOCKET_ERROR )
+			sent++;
+	}
+
+	Msg( "net_loadtest: sent %i of %i packets from %i clients in %.2f ms\n", sent, numpackets, numclients, ( Sys_DoubleTime() - start ) * 1000.0 );
+	Msg( "use net_recvstats to see how server handles them\n" );
+
+	pCloseSocket( net_socket );
+}
+
 /*
 ====================
 NET_Config
@@ -1522,11 +1856,15 @@ void NET_Config( qboolean multiplayer )
 			NET_GetLocalAddress();
 			bFirst = false;
 		}
+
+		NET_StartRecvThread();
 	}
 	else
 	{	
 		int	i;
 
+		NET_StopRecvThread();
+
 		// shut down any existing sockets
 		for( i = 0; i < NS_COUNT; i++ )
 		{
@@ -1587,6 +1925,14 @@ void NET_Sleep( int msec )
 	if( !net.initialized || host.type == HOST_NORMAL )
 		return; // we're not a dedicated server, just run full speed
 
+	if( net.recv_thread )
+	{
+		// sockets are drained by receive thread, wait for it
+		if( net.recv_queue->head == net.recv_queue->tail )
+			WaitForSingleObject( net.recv_event, msec );
+		return;
+	}
+
 	FD_ZERO( &fdset );
 
 	if( net.ip_sockets[NS_SERVER] != INVALID_SOCKET )
@@ -1644,6 +1990,9 @@ void NET_Init( void )
 	net_fakelag = Cvar_Get( "fakelag", "0", 0, "lag all incoming network data (including loopback) by xxx ms." );
 	net_fakeloss = Cvar_Get( "fakeloss", "0", 0, "act like we dropped the packet this % of the time." );
 
+	Cmd_AddCommand( "net_recvstats", NET_RecvStats_f, "show server packets receiving statistics, 'reset' to clear" );
+	Cmd_AddCommand( "net_loadtest", NET_LoadTest_f, "send a lot of game packets to local server from fake clients" );
+
 	// prepare some network data
 	for( i = 0; i < NS_COUNT; i++ )
 	{
@@ -99,6 +99,9 @@ NET
 // size of fragmentation buffer internal buffers
 #define FRAGMENT_MAX_SIZE 		1024
 
+// resent compressed fragment which still can't be unpacked is malformed
+#define NET_MAX_BAD_FRAGMENTS		3
+
 #define FRAG_NORMAL_STREAM		0
 #define FRAG_FILE_STREAM		1
 
@@ -149,6 +152,8 @@ typedef struct fragbuf_s
 	char		filename[MAX_OSPATH];		// name of the file to save out on remote host
 	int		foffset;				// offset in file from which to read data  
 	int		size;				// size of data to read at that offset
+	struct netfile_s	*filecache;			// shared file data from downloads cache
+	int		filefrag;				// fragment number in the cached file
 } fragbuf_t;
 
 // Waiting list of fragbuf chains
@@ -205,6 +210,7 @@ typedef struct netchan_s
 
 	short		frag_startpos[MAX_STREAMS];	// position in outgoing buffer where frag data starts
 	short		frag_length[MAX_STREAMS];	// length of frag data in the buffer
+	qboolean		frag_compressed[MAX_STREAMS];	// frag data in the buffer is LZSS block
 
 	fragbuf_t		*incomingbufs[MAX_STREAMS];	// incoming fragments are stored here
 	qboolean		incomingready[MAX_STREAMS];	// set to true when incoming data is ready
@@ -221,6 +227,15 @@ typedef struct netchan_s
 	// added for net_speeds
 	size_t		total_sended;
 	size_t		total_received;
+
+	// fragment compression, enabled when remote side has reported that it can decompress
+	qboolean		compress;
+	size_t		total_uncompressed;		// outgoing fragments before compression
+	size_t		total_compressed;		// the same fragments as they sent
+	double		compress_time;
+	size_t		total_decompressed;		// incoming fragments after decompression
+	double		decompress_time;
+	int		bad_fragments;		// compressed fragments failed to unpack in a row
 } netchan_t;
 
 extern netadr_t		net_from;
@@ -229,6 +244,7 @@ extern netadr_t		net_local_ipx;
 extern sizebuf_t		net_message;
 extern byte		net_message_buffer[NET_MAX_PAYLOAD];
 extern convar_t		*net_speeds;
+extern convar_t		*net_compress;
 extern int		net_drop;
 
 void Netchan_Init( void );
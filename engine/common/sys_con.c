@@ -474,6 +474,255 @@ SYSTEM LOG
 
 ===============================================================================
 */
+#define LOG_QUEUE_SLOTS	2048		// must be power of two
+#define LOG_QUEUE_MASK	(LOG_QUEUE_SLOTS - 1)
+#define LOG_SLOT_SIZE	256		// long messages takes a few slots in a row
+#define LOG_MAX_SLOTS	(LOG_QUEUE_SLOTS / 4)	// for single message
+#define LOG_BATCH_SIZE	65536
+#define LOG_FLUSH_TIME	100		// msec, can be changed with -logflush
+
+typedef struct
+{
+	volatile long	sequence;		// position + 1 when filled, position + LOG_QUEUE_SLOTS when free
+	int		length;
+	char		text[LOG_SLOT_SIZE];
+} logslot_t;
+
+// bounded multi-producer queue, slots are reserved with single CAS
+// and drained by writer thread that writes them into the file in batches
+typedef struct
+{
+	logslot_t		slots[LOG_QUEUE_SLOTS];
+	volatile long	enqueue_pos;
+	volatile long	dequeue_pos;	// changed by writer only
+	volatile long	dropped;		// messages lost due to full queue
+	volatile long	shutdown;
+	int		flushtime;
+	char		lastchar;		// don't put drop notice into the middle of line
+	HANDLE		hThread;
+	HANDLE		hWakeup;
+	char		batch[LOG_BATCH_SIZE];
+} logqueue_t;
+
+static logqueue_t	s_log;
+
+/*
+================
+Sys_QueueLog
+
+called from any thread, never blocks
+================
+*/
+static void Sys_QueueLog( const char *text, int len )
+{
+	int	i, count, size;
+	long	pos, last, diff;
+	logslot_t	*slot;
+
+	if( len <= 0 ) return;
+
+	// if the message is REALLY long, use just the last portion of it
+	if( len > LOG_MAX_SLOTS * LOG_SLOT_SIZE )
+	{
+		text += len - LOG_MAX_SLOTS * LOG_SLOT_SIZE;
+		len = LOG_MAX_SLOTS * LOG_SLOT_SIZE;
+	}
+
+	count = ( len + LOG_SLOT_SIZE - 1 ) / LOG_SLOT_SIZE;
+
+	while( 1 )
+	{
+		pos = s_log.enqueue_pos;
+		last = pos + count - 1;
+		diff = s_log.slots[last & LOG_QUEUE_MASK].sequence - last;
+
+		// writer frees slots in order, so if the last one
+		// is free then all the slots before are free too
+		if( diff < 0 )
+		{
+			InterlockedIncrement( (long *)&s_log.dropped );
+			SetEvent( s_log.hWakeup );
+			return;
+		}
+
+		// another thread has reserved this position, try again
+		if( diff > 0 ) continue;
+
+		if( InterlockedCompareExchange( (long *)&s_log.enqueue_pos, pos + count, pos ) == pos )
+			break;
+	}
+
+	for( i = 0; i < count; i++ )
+	{
+		slot = &s_log.slots[(pos + i) & LOG_QUEUE_MASK];
+		size = Q_min( len, LOG_SLOT_SIZE );
+		memcpy( slot->text, text, size );
+		slot->length = size;
+		text += size;
+		len -= size;
+
+		// publish it to the writer
+		InterlockedExchange( (long *)&slot->sequence, pos + i + 1 );
+	}
+
+	// don't wait the timeout when queue is half full
+	if(( pos + count - s_log.dequeue_pos ) > ( LOG_QUEUE_SLOTS / 2 ))
+		SetEvent( s_log.hWakeup );
+}
+
+/*
+================
+Sys_DrainLog
+
+write all queued messages with a few calls of fwrite,
+must be called only by one thread at the time
+================
+*/
+static void Sys_DrainLog( void )
+{
+	int	dropped, batchlen = 0;
+	long	pos = s_log.dequeue_pos;
+	logslot_t	*slot;
+
+	while( 1 )
+	{
+		slot = &s_log.slots[pos & LOG_QUEUE_MASK];
+
+		// not filled yet
+		if( slot->sequence != pos + 1 )
+			break;
+
+		if( batchlen + slot->length > LOG_BATCH_SIZE )
+		{
+			fwrite( s_log.batch, 1, batchlen, s_wcd.logfile );
+			batchlen = 0;
+		}
+
+		memcpy( s_log.batch + batchlen, slot->text, slot->length );
+		batchlen += slot->length;
+
+		// give slot back to producers
+		InterlockedExchange( (long *)&slot->sequence, pos + LOG_QUEUE_SLOTS );
+		pos++;
+	}
+
+	InterlockedExchange( (long *)&s_log.dequeue_pos, pos );
+
+	if( batchlen )
+	{
+		fwrite( s_log.batch, 1, batchlen, s_wcd.logfile );
+		s_log.lastchar = s_log.batch[batchlen - 1];
+	}
+
+	if( s_log.lastchar == '\n' )
+		dropped = InterlockedExchange( (long *)&s_log.dropped, 0 );
+	else dropped = 0;
+
+	if( dropped )
+		fprintf( s_wcd.logfile, "*** %i log messages was dropped ***\n", dropped );
+
+	if( batchlen || dropped )
+		fflush( s_wcd.logfile );
+}
+
+/*
+================
+Sys_LogThread
+
+================
+*/
+static DWORD WINAPI Sys_LogThread( void *unused )
+{
+	while( !s_log.shutdown )
+	{
+		WaitForSingleObject( s_log.hWakeup, s_log.flushtime );
+		Sys_DrainLog();
+	}
+
+	return 0;
+}
+
+/*
+================
+Sys_StartLogThread
+
+================
+*/
+static void Sys_StartLogThread( void )
+{
+	char	parm[16];
+	DWORD	id;
+	int	i;
+
+	s_log.flushtime = LOG_FLUSH_TIME;
+	s_log.enqueue_pos = s_log.dequeue_pos = 0;
+	s_log.dropped = s_log.shutdown = 0;
+	s_log.lastchar = '\n';
+
+	if( Sys_GetParmFromCmdLine( "-logflush", parm ))
+		s_log.flushtime = bound( 1, Q_atoi( parm ), 5000 );
+
+	for( i = 0; i < LOG_QUEUE_SLOTS; i++ )
+		s_log.slots[i].sequence = i;
+
+	s_log.hWakeup = CreateEvent( NULL, FALSE, FALSE, NULL );
+	if( !s_log.hWakeup ) return;
+
+	s_log.hThread = CreateThread( NULL, 0, Sys_LogThread, NULL, 0, &id );
+
+	if( !s_log.hThread )
+	{
+		// write log synchronously
+		CloseHandle( s_log.hWakeup );
+		s_log.hWakeup = NULL;
+	}
+}
+
+/*
+================
+Sys_StopLogThread
+
+================
+*/
+static void Sys_StopLogThread( void )
+{
+	if( !s_log.hThread ) return;
+
+	InterlockedExchange( (long *)&s_log.shutdown, 1 );
+	SetEvent( s_log.hWakeup );
+	WaitForSingleObject( s_log.hThread, INFINITE );
+	CloseHandle( s_log.hThread );
+	CloseHandle( s_log.hWakeup );
+	s_log.hThread = s_log.hWakeup = NULL;
+
+	// write the rest
+	Sys_DrainLog();
+}
+
+/*
+================
+Sys_FlushLog
+
+wait while writer thread puts all queued
+messages on disk, used before fatal exit
+================
+*/
+void Sys_FlushLog( void )
+{
+	long	pos = s_log.enqueue_pos;
+	int	i;
+
+	if( !s_wcd.logfile || !s_log.hThread )
+		return;
+
+	// writer may be hung or dead, don't wait forever
+	for( i = 0; i < 200 && ( s_log.dequeue_pos - pos ) < 0; i++ )
+	{
+		SetEvent( s_log.hWakeup );
+		Sleep( 5 );
+	}
+}
+
 void Sys_InitLog( void )
 {
 	const char	*mode;
@@ -491,6 +740,8 @@ void Sys_InitLog( void )
 		fprintf( s_wcd.logfile, "=================================================================================\n" );
 		fprintf( s_wcd.logfile, "\t%s (build %i) started at %s\n", s_wcd.title, Q_buildnum(), Q_timestamp( TIME_FULL ));
 		fprintf( s_wcd.logfile, "=================================================================================\n" );
+
+		Sys_StartLogThread();
 	}
 }
 
@@ -515,6 +766,8 @@ void Sys_CloseLog( void )
 
 	if( s_wcd.logfile )
 	{
+		Sys_StopLogThread();
+
 		fprintf( s_wcd.logfile, "\n");
 		fprintf( s_wcd.logfile, "=================================================================================");
 		if( host.change_game ) fprintf( s_wcd.logfile, "\n\t%s (build %i) %s\n", s_wcd.title, Q_buildnum(), event_name );
@@ -530,6 +783,13 @@ void Sys_CloseLog( void )
 void Sys_PrintLog( const char *pMsg )
 {
 	if( !s_wcd.logfile ) return;
-	fprintf( s_wcd.logfile, pMsg );
+
+	if( s_log.hThread )
+	{
+		Sys_QueueLog( pMsg, Q_strlen( pMsg ));
+		return;
+	}
+
+	fputs( pMsg, s_wcd.logfile );
 	fflush( s_wcd.logfile );
 }
\ No newline at end of file
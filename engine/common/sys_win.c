@@ -450,6 +450,7 @@ long _stdcall Sys_Crash( PEXCEPTION_POINTERS pInfo )
 		else host.state = HOST_CRASHED;
 
 		Msg( "Sys_Crash: call %p at address %p\n", pInfo->ExceptionRecord->ExceptionAddress, pInfo->ExceptionRecord->ExceptionCode );
+		Sys_FlushLog();
 
 		if( host.developer <= 0 )
 		{
@@ -504,11 +505,13 @@ void Sys_Error( const char *error, ... )
 		Con_ShowConsole( true );
 		Con_DisableInput();	// disable input line for dedicated server
 		Sys_Print( text );	// print error message
+		Sys_FlushLog();
 		Sys_WaitForQuit();
 	}
 	else
 	{
 		Con_ShowConsole( false );
+		Sys_FlushLog();
 		MSGBOX( text );
 	}
 
@@ -85,6 +85,7 @@ void Sys_ShellExecute( const char *path, const char *parms, qboolean exit );
 void Sys_SendKeyEvents( void );
 void Sys_Print( const char *pMsg );
 void Sys_PrintLog( const char *pMsg );
+void Sys_FlushLog( void );
 void Sys_InitLog( void );
 void Sys_CloseLog( void );
 void Sys_Quit( void );
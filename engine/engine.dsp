@@ -383,6 +383,10 @@ SOURCE=.\common\library.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\common\lzss.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\common\mathlib.c
 # End Source File
 # Begin Source File
@@ -523,6 +527,10 @@ SOURCE=.\server\sv_pmove.c
 # End Source File
 # Begin Source File
 
+SOURCE=.\server\sv_profile.c
+# End Source File
+# Begin Source File
+
 SOURCE=.\server\sv_save.c
 # End Source File
 # Begin Source File
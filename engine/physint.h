@@ -16,7 +16,8 @@ GNU General Public License for more details.
 #ifndef PHYSINT_H
 #define PHYSINT_H
 
-#define SV_PHYSICS_INTERFACE_VERSION	6
+#define SV_PHYSICS_INTERFACE_VERSION	7
+#define SV_PHYSICS_INTERFACE_VERSION_6	6	// without pfnEntitiesInBox
 
 #define STRUCT_FROM_LINK( l, t, m )	((t *)((byte *)l - (int)&(((t *)0)->m)))
 #define EDICT_FROM_AREA( l )		STRUCT_FROM_LINK( l, edict_t, area )
@@ -55,6 +56,7 @@ typedef struct areanode_s
 	struct areanode_s	*children[2];
 	link_t		trigger_edicts;
 	link_t		solid_edicts;
+	link_t		nonsolid_edicts;	// only for area queries, never clipped or touched
 } areanode_t;
 
 typedef struct server_physics_api_s
@@ -105,6 +107,9 @@ typedef struct server_physics_api_s
 	const byte	*(*pfnLoadImagePixels)( const char *filename, int *width, int *height );
 
 	const char*	(*pfnGetModelName)( int modelindex );
+
+	// fill list with entities which absbox touches the box, sorted by entity index (flagMask 0 is any entity)
+	int		(*pfnEntitiesInBox)( const float *mins, const float *maxs, edict_t **list, int maxcount, int flagMask );
 } server_physics_api_t;
 
 // physic callbacks
@@ -54,6 +54,11 @@ extern int SV_UPDATE_BACKUP;
 
 #define MAX_PUSHED_ENTS	256
 #define MAX_VIEWENTS	128
+#define MAX_UNLAG_ENTS	128		// non-player entities with lag compensation history
+
+#define MAX_MULTICAST_PAYLOADS	2048		// unreliable multicasts per frame
+#define MULTICAST_ARENA_SIZE	(MAX_MULTICAST * 32)
+#define MAX_CLIENT_MULTICASTS	256		// payload references per client datagram
 
 #define FCL_RESEND_USERINFO	BIT( 0 )
 #define FCL_RESEND_MOVEVARS	BIT( 1 )
@@ -81,6 +86,36 @@ typedef enum
 	cs_spawned	// client is fully in game
 } cl_state_t;
 
+// server frame profiler phases
+typedef enum
+{
+	SVP_FRAME = 0,		// whole Host_ServerFrame
+	SVP_READPACKETS,
+	SVP_CLIENTCOMMAND,
+	SVP_PLAYERPRETHINK,
+	SVP_PLAYERMOVE,
+	SVP_PLAYERPOSTTHINK,
+	SVP_TIMEOUTS,
+	SVP_GAMEFRAME,
+	SVP_PHYSICS,
+	SVP_STARTFRAME,
+	SVP_THINK,
+	SVP_TOUCH,
+	SVP_BLOCKED,
+	SVP_PARALLEL,
+	SVP_SENDMESSAGES,
+	SVP_SETUPVISIBILITY,
+	SVP_ADDTOFULLPACK,
+	SVP_UPDATECLIENTDATA,
+	SVP_PREPWORLD,
+	SVP_HEARTBEAT,
+	SVP_COUNT
+} sv_phase_t;
+
+// phase timers are compiled in but cost only a check while sv_profile is off
+#define SV_BeginPhase( phase )	( svs.profiling ? SV_ProfileBegin( phase ) : (void)0 )
+#define SV_EndPhase( phase )		( svs.profiling ? SV_ProfileEnd( phase ) : (void)0 )
+
 // instanced baselines container
 typedef struct
 {
@@ -89,6 +124,23 @@ typedef struct
 	entity_state_t	baselines[64];
 } sv_baselines_t;
 
+// unreliable multicast payload, shared between clients
+typedef struct
+{
+	int		offset;			// in svs.multicast_arena
+	int		numbits;
+	int		refcount;			// clients that doesn't send it yet
+} sv_multicast_t;
+
+typedef struct
+{
+	int		payloads;			// stored into arena once
+	int		references;		// linked to client datagrams
+	int		stored_bytes;		// written into arena
+	int		copied_bytes;		// copied into client datagrams and packets
+	int		percopy_bytes;		// would be copied with per-client buffers
+} sv_mcaststats_t;
+
 typedef struct
 {
 	const char	*name;
@@ -177,6 +229,11 @@ typedef struct server_s
 	qboolean		simulating;
 	qboolean		write_bad_message;	// just for debug
 	qboolean		paused;
+
+	int		physics_active;	// entities was run by SV_Physics last frame
+	int		physics_idle;	// static entities skipped by SV_Physics last frame
+	int		physics_sleeping;	// entities at rest skipped by SV_Physics last frame
+	int		physics_parallel;	// toss moves traced by worker threads last frame
 } server_t;
 
 typedef struct
@@ -240,6 +297,12 @@ typedef struct sv_client_s
 	sizebuf_t		datagram;
 	byte		datagram_buf[MAX_DATAGRAM];
 
+	// shared multicast payloads that will be spliced into next datagram,
+	// always newer than anything is written into datagram buffer
+	short		multicasts[MAX_CLIENT_MULTICASTS];
+	int		num_multicasts;
+	int		multicast_bits;		// total size of referenced payloads
+
 	client_frame_t	*frames;			// updates can be delta'd from here
 	event_state_t	events;
 
@@ -250,6 +313,8 @@ typedef struct sv_client_s
 	int		userid;			// identifying number on server
 	int		authentication_method;
 	uint		WonID;			// WonID
+
+	struct sv_client_s	*hashnext;		// next client in svs.clienthash chain
 } sv_client_t;
 
 /*
@@ -267,6 +332,9 @@ typedef struct sv_client_s
 // out before legitimate users connected
 #define MAX_CHALLENGES	1024
 
+// connected clients lookup by ( base address, qport )
+#define SV_CLIENT_HASH_SIZE	(MAX_CLIENTS * 2)
+
 typedef struct
 {
 	netadr_t		adr;
@@ -296,6 +364,7 @@ typedef struct
 	qboolean		moving;
 	qboolean		firstframe;
 	qboolean		nointerp;
+	int		serialnumber;	// edict the positions were saved for
 
 	vec3_t		mins;
 	vec3_t		maxs;
@@ -304,6 +373,10 @@ typedef struct
 	vec3_t		oldpos;
 	vec3_t		newpos;
 	vec3_t		finalpos;
+
+	qboolean		resized;		// hull was changed to the rewound one
+	vec3_t		oldmins;
+	vec3_t		oldmaxs;
 } sv_interp_t;
 
 typedef struct
@@ -335,7 +408,7 @@ typedef struct
 	movevars_t	movevars;			// curstate
 	movevars_t	oldmovevars;		// oldstate
 	playermove_t	*pmove;			// pmove state
-	sv_interp_t	interp[MAX_CLIENTS];	// interpolate clients
+	sv_interp_t	interp[MAX_CLIENTS+MAX_UNLAG_ENTS];	// interpolate clients and FL_LAGCOMPENSATE entities
 
 	sv_pushed_t	pushed[MAX_PUSHED_ENTS];	// no reason to keep array for all edicts
 						// 256 it should be enough for any game situation
@@ -348,12 +421,15 @@ typedef struct
 	byte		*stringspool;		// for engine strings
 
 	SAVERESTOREDATA	SaveData;			// shared struct, used for save data
+	int		numFuncLookups;		// FunctionFromName calls since last restore
+	double		funcLookupTime;		// time spent in them
 } svgame_static_t;
 
 typedef struct
 {
 	qboolean		initialized;		// sv_init has completed
 	double		timestart;		// just for profiling
+	qboolean		profiling;		// sv_profile is latched each frame
 
 	int		maxclients;		// server max clients
 
@@ -367,6 +443,7 @@ typedef struct
 	int		spawncount;		// incremented each server start
 						// used to check late spawns
 	sv_client_t	*clients;			// [svs.maxclients]
+	sv_client_t	*clienthash[SV_CLIENT_HASH_SIZE];	// to find packet sender quickly
 	sv_client_t	*currentPlayer;		// current client who network message sending on
 	int		currentPlayerNum;		// for easy acess to some global arrays
 	int		num_client_entities;	// svs.maxclients*UPDATE_BACKUP*MAX_PACKET_ENTITIES
@@ -376,6 +453,15 @@ typedef struct
 
 	double		last_heartbeat;
 	challenge_t	challenges[MAX_CHALLENGES];	// to prevent invalid IPs from connecting
+
+	// unreliable multicasts are stored once per frame and referenced by clients
+	sv_multicast_t	multicasts[MAX_MULTICAST_PAYLOADS];
+	int		num_multicasts;
+	byte		multicast_arena[MULTICAST_ARENA_SIZE];
+	int		multicast_arena_used;
+	sv_mcaststats_t	mcast_frame;		// current frame
+	sv_mcaststats_t	mcast_total;		// since stats reset
+	int		mcast_frames;
 } server_static_t;
 
 //=============================================================================
@@ -396,6 +482,10 @@ extern convar_t		sv_instancedbaseline;
 extern convar_t		sv_minupdaterate;
 extern convar_t		sv_maxupdaterate;
 extern convar_t		sv_newunit;
+extern convar_t		sv_save_compress;
+extern convar_t		sv_skipidle;
+extern convar_t		sv_sleepents;
+extern convar_t		sv_physthreads;
 extern convar_t		sv_clienttrace;
 extern convar_t		sv_failuretime;
 extern convar_t		sv_send_resources;
@@ -456,6 +546,8 @@ void SV_PrepWorldFrame( void );
 void SV_ProcessFile( sv_client_t *cl, char *filename );
 void SV_SendResourceList( sv_client_t *cl );
 void SV_AddToMaster( netadr_t from, sizebuf_t *msg );
+void SV_LinkClientAddress( sv_client_t *cl );
+void SV_UnlinkClientAddress( sv_client_t *cl );
 qboolean SV_IsSimulating( void );
 void Master_Add( void );
 void Master_Heartbeat( void );
@@ -481,6 +573,9 @@ qboolean SV_RunThink( edict_t *ent );
 qboolean SV_PlayerRunThink( edict_t *ent, float frametime, double time );
 qboolean SV_TestEntityPosition( edict_t *ent, edict_t *blocker );	// for EntityInSolid checks
 void SV_Impact( edict_t *e1, edict_t *e2, trace_t *trace );
+void SV_WakeEdict( edict_t *ent );
+qboolean SV_DeferTossMove( edict_t *ent, const vec3_t lpush );
+void SV_StopPhysicsThreads( void );
 qboolean SV_CanPushed( edict_t *ent );
 void SV_FreeOldEntities( void );
 void SV_CheckAllEnts( void );
@@ -550,6 +645,10 @@ void SV_BuildClientFrame( sv_client_t *client );
 void SV_InactivateClients( void );
 void SV_SendMessagesToAll( void );
 void SV_SkipUpdates( void );
+int SV_StoreMulticast( sizebuf_t *msg );
+void SV_LinkMulticast( sv_client_t *cl, int payload, sizebuf_t *msg );
+void SV_ReleaseClientMulticasts( sv_client_t *cl );
+void SV_ClearMulticasts( void );
 
 //
 // sv_game.c
@@ -609,6 +708,8 @@ _inline edict_t *SV_EDICT_NUM( int n, const char * file, const int line )
 //
 void SV_ClearSaveDir( void );
 void SV_SaveGame( const char *pName );
+void SV_FinishSaveGame( qboolean wait );
+void SV_SaveInfo_f( void );
 qboolean SV_LoadGame( const char *pName );
 void SV_ChangeLevel( qboolean loadfromsavedgame, const char *mapname, const char *start );
 int SV_LoadGameState( char const *level, qboolean createPlayers );
@@ -621,6 +722,8 @@ void SV_InitSaveRestore( void );
 //
 void SV_GetTrueOrigin( sv_client_t *cl, int edictnum, vec3_t origin );
 void SV_GetTrueMinMax( sv_client_t *cl, int edictnum, vec3_t mins, vec3_t maxs );
+void SV_RecordUnlagHistory( void );
+void SV_ClearUnlagHistory( void );
 qboolean SV_PlayerIsFrozen( edict_t *pClient );
 
 //
@@ -632,12 +735,15 @@ void SV_ClipMoveToEntity( edict_t *ent, const vec3_t start, vec3_t mins, vec3_t
 void SV_CustomClipMoveToEntity( edict_t *ent, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, trace_t *trace );
 trace_t SV_TraceHull( edict_t *ent, int hullNum, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end );
 trace_t SV_Move( const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int type, edict_t *e, qboolean monsterclip );
+trace_t SV_MoveFromWorldTrace( const trace_t *worldtrace, const vec3_t start, vec3_t mins, vec3_t maxs, int type, edict_t *e, qboolean monsterclip );
 trace_t SV_MoveNoEnts( const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int type, edict_t *e );
 trace_t SV_MoveNormal( const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int type, edict_t *e );
 const char *SV_TraceTexture( edict_t *ent, const vec3_t start, const vec3_t end );
 msurface_t *SV_TraceSurface( edict_t *ent, const vec3_t start, const vec3_t end );
 trace_t SV_MoveToss( edict_t *tossent, edict_t *ignore );
 void SV_LinkEdict( edict_t *ent, qboolean touch_triggers );
+int SV_AreaEdicts( const vec3_t mins, const vec3_t maxs, edict_t **list, int maxcount, int flagmask );
+qboolean SV_AreaHasSolids( areanode_t *node, const vec3_t mins, const vec3_t maxs, edict_t *passedict );
 void SV_TouchLinks( edict_t *ent, areanode_t *node );
 int SV_TruePointContents( const vec3_t p );
 int SV_PointContents( const vec3_t p );
@@ -647,4 +753,14 @@ const char *SV_GetLightStyle( int style );
 int SV_LightForEntity( edict_t *pEdict );
 void SV_ClearPhysEnts( void );
 
+//
+// sv_profile.c
+//
+void SV_InitProfiler( void );
+void SV_ShutdownProfiler( void );
+void SV_ProfileFrameBegin( void );
+void SV_ProfileFrameEnd( void );
+void SV_ProfileBegin( sv_phase_t phase );
+void SV_ProfileEnd( sv_phase_t phase );
+
 #endif//SERVER_H
\ No newline at end of file
@@ -40,6 +40,12 @@ typedef struct ucmd_s
 	void		(*func)( sv_client_t *cl );
 } ucmd_t;
 
+typedef struct oobcmd_s
+{
+	const char	*name;
+	void		(*func)( netadr_t from );
+} oobcmd_t;
+
 static int	g_userid = 1;
 
 /*
@@ -125,6 +131,7 @@ void SV_DirectConnect( netadr_t from )
 	int		i, edictnum;
 	int		count = 0;
 	int		challenge;
+	qboolean		compress;
 	edict_t		*ent;
 
 	version = Q_atoi( Cmd_Argv( 1 ));
@@ -140,6 +147,7 @@ void SV_DirectConnect( netadr_t from )
 	qport = Q_atoi( Cmd_Argv( 2 ));
 	challenge = Q_atoi( Cmd_Argv( 3 ));
 	Q_strncpy( userinfo, Cmd_Argv( 4 ), sizeof( userinfo ));
+	compress = !Q_stricmp( Cmd_Argv( 5 ), "lzss" ); // client can decompress fragments
 
 	// quick reject
 	for( i = 0, cl = svs.clients; i < svs.maxclients; i++, cl++ )
@@ -230,6 +238,8 @@ gotnewcl:
 	if( svs.maxclients == 1 ) // save physinfo for singleplayer
 		Q_strncpy( physinfo, newcl->physinfo, sizeof( physinfo ));
 
+	SV_UnlinkClientAddress( newcl );
+	SV_ReleaseClientMulticasts( newcl );
 	*newcl = temp;
 
 	if( svs.maxclients == 1 ) // restore physinfo for singleplayer
@@ -248,7 +258,9 @@ gotnewcl:
 
 	// initailize netchan here because SV_DropClient will clear network buffer
 	Netchan_Setup( NS_SERVER, &newcl->netchan, from, qport, newcl, SV_GetFragmentSize );
+	newcl->netchan.compress = compress;
 	MSG_Init( &newcl->datagram, "Datagram", newcl->datagram_buf, sizeof( newcl->datagram_buf )); // datagram buf
+	SV_LinkClientAddress( newcl );
 
 	// get the game a chance to reject this connection or modify the userinfo
 	if( !( SV_ClientConnect( ent, userinfo )))
@@ -263,8 +275,8 @@ gotnewcl:
 		return;
 	}
 
-	// send the connect packet to the client
-	Netchan_OutOfBandPrint( NS_SERVER, from, "client_connect" );
+	// send the connect packet to the client, old clients will ignore an extra argument
+	Netchan_OutOfBandPrint( NS_SERVER, from, "client_connect lzss" );
 
 	newcl->state = cs_connected;
 	newcl->lastmessage = host.realtime;
@@ -358,6 +370,8 @@ edict_t *SV_FakeConnect( const char *netname )
 	// build a new connection
 	// accept the new client
 	// this is the only place a sv_client_t is ever initialized
+	SV_UnlinkClientAddress( newcl );
+	SV_ReleaseClientMulticasts( newcl );
 	*newcl = temp;
 	svs.currentPlayer = newcl;
 	svs.currentPlayerNum = (newcl - svs.clients);
@@ -2099,7 +2113,9 @@ void SV_ExecuteClientCommand( sv_client_t *cl, char *s )
 	if( !u->name && sv.state == ss_active )
 	{
 		// custom client commands
+		SV_BeginPhase( SVP_CLIENTCOMMAND );
 		svgame.dllFuncs.pfnClientCommand( cl->edict );
+		SV_EndPhase( SVP_CLIENTCOMMAND );
 
 		if( !Q_strcmp( Cmd_Argv( 0 ), "fullupdate" ))
 		{
@@ -2180,6 +2196,59 @@ void SV_TSourceEngineQuery( netadr_t from )
 	NET_SendPacket( NS_SERVER, MSG_GetNumBytesWritten( &buf ), MSG_GetData( &buf ), from );
 }
 
+/*
+==================
+SV_A2APing
+==================
+*/
+static void SV_A2APing( netadr_t from )
+{
+	NET_SendPacket( NS_SERVER, 5, "\xFF\xFF\xFF\xFFj", from ); // A2A_PING
+}
+
+// connectionless commands without arguments
+static const oobcmd_t sv_fastoobcmds[] =
+{
+{ "ping",		SV_Ping },
+{ "ack",		SV_Ack },
+{ "getchallenge",	SV_GetChallenge },
+{ "T" "Source",	SV_TSourceEngineQuery },
+{ "i",		SV_A2APing },
+{ NULL,		NULL }
+};
+
+/*
+==================
+SV_FastConnectionlessPacket
+
+dispatch queries that doesn't need arguments
+straight from the packet header, so query
+floods never reach the tokenizer
+==================
+*/
+static qboolean SV_FastConnectionlessPacket( netadr_t from, sizebuf_t *msg )
+{
+	const char	*data = (const char *)msg->pData + 4;
+	int		size = MSG_GetMaxBytes( msg ) - 4;
+	const oobcmd_t	*cmd;
+	int		len;
+
+	// measure first token
+	for( len = 0; len < size && (byte)data[len] > ' '; len++ );
+	if( len == 0 ) return false;
+
+	for( cmd = sv_fastoobcmds; cmd->name; cmd++ )
+	{
+		if( Q_strlen( cmd->name ) == len && !memcmp( cmd->name, data, len ))
+		{
+			cmd->func( from );
+			return true;
+		}
+	}
+
+	return false;
+}
+
 /*
 =================
 SV_ConnectionlessPacket
@@ -2196,6 +2265,9 @@ void SV_ConnectionlessPacket( netadr_t from, sizebuf_t *msg )
 	char	*pcmd, buf[MAX_SYSPATH];
 	int	len = sizeof( buf );
 
+	if( SV_FastConnectionlessPacket( from, msg ))
+		return;
+
 	MSG_Clear( msg );
 	MSG_ReadLong( msg );// skip the -1 marker
 
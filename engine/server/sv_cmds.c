@@ -935,6 +935,8 @@ void SV_EdictUsage_f( void )
 	Msg( "%5i edicts is used\n", active );
 	Msg( "%5i edicts is free\n", svgame.globals->maxEntities - active );
 	Msg( "%5i total\n", svgame.globals->maxEntities );
+	Msg( "%5i edicts was run by physics last frame, %i idle and %i sleeping skipped\n", sv.physics_active, sv.physics_idle, sv.physics_sleeping );
+	Msg( "%5i toss moves was traced in parallel last frame\n", sv.physics_parallel );
 }
 
 /*
@@ -979,6 +981,160 @@ void SV_EntityInfo_f( void )
 		Msg( "\n" );
 	}
 }
+
+/*
+===============
+SV_MulticastStats_f
+
+compare shared multicast payloads with per-client copies
+===============
+*/
+void SV_MulticastStats_f( void )
+{
+	sv_mcaststats_t	*total = &svs.mcast_total;
+	int		frames = Q_max( svs.mcast_frames, 1 );
+
+	if( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ))
+	{
+		memset( total, 0, sizeof( *total ));
+		svs.mcast_frames = 0;
+		return;
+	}
+
+	Msg( "multicasts over %i frames (per frame):\n", svs.mcast_frames );
+	Msg( "%.1f payloads stored, %.1f client references\n", (float)total->payloads / frames, (float)total->references / frames );
+	Msg( "%s stored into shared arena\n", Q_memprint( (float)total->stored_bytes / frames ));
+	Msg( "%s copied into client buffers\n", Q_memprint( (float)total->copied_bytes / frames ));
+	Msg( "%s would be copied with per-client buffers\n", Q_memprint( (float)total->percopy_bytes / frames ));
+}
+
+/*
+===============
+SV_LinearEntitiesInBox
+
+the same query as SV_AreaEdicts but with scan over all
+edicts, like game dlls did it before
+===============
+*/
+static int SV_LinearEntitiesInBox( const vec3_t mins, const vec3_t maxs, edict_t **list, int maxcount, int flagmask )
+{
+	edict_t	*ent;
+	int	i, count = 0;
+
+	for( i = 1; i < svgame.globals->maxEntities && count < maxcount; i++ )
+	{
+		ent = EDICT_NUM( i );
+
+		if( ent->free ) continue;
+
+		if( flagmask && !FBitSet( ent->v.flags, flagmask ))
+			continue;
+
+		if( !BoundsIntersect( mins, maxs, ent->v.absmin, ent->v.absmax ))
+			continue;
+
+		list[count++] = ent;
+	}
+
+	return count;
+}
+
+/*
+===============
+SV_AreaBench_f
+
+time entities in box queries on the current map, adds
+temporary entities to build a scene of required size
+===============
+*/
+void SV_AreaBench_f( void )
+{
+	int		numents, numqueries, spawned = 0;
+	int		i, j, count1, count2, mismatches = 0;
+	double		start, areatime, lineartime;
+	edict_t		*list1[256], *list2[256];
+	edict_t		**temp;
+	vec3_t		mins, maxs, size;
+	float		boxsize;
+
+	if( sv.state != ss_active )
+	{
+		Msg( "^3no server running.\n" );
+		return;
+	}
+
+	numents = ( Cmd_Argc() > 1 ) ? Q_atoi( Cmd_Argv( 1 )) : 512;
+	boxsize = ( Cmd_Argc() > 2 ) ? Q_atof( Cmd_Argv( 2 )) : 1024.0f;
+	numqueries = 10000;
+
+	// keep some edicts for the game
+	numents = Q_min( numents - pfnNumberOfEntities(), svgame.globals->maxEntities - svgame.numEntities - 64 );
+	temp = Mem_Alloc( host.mempool, sizeof( edict_t* ) * Q_max( numents, 1 ));
+	COM_SetRandomSeed( 1 ); // the same scene for each run
+
+	for( i = 0; i < numents; i++ )
+	{
+		edict_t	*ent = SV_AllocEdict();
+
+		for( j = 0; j < 3; j++ )
+			ent->v.origin[j] = COM_RandomFloat( sv.worldmodel->mins[j], sv.worldmodel->maxs[j] );
+		VectorSet( ent->v.mins, -16.0f, -16.0f, 0.0f );
+		VectorSet( ent->v.maxs, 16.0f, 16.0f, 72.0f );
+		VectorAdd( ent->v.origin, ent->v.mins, ent->v.absmin );
+		VectorAdd( ent->v.origin, ent->v.maxs, ent->v.absmax );
+
+		// mix of monsters, triggers and non-solid entities
+		switch( i % 3 )
+		{
+		case 0:
+			ent->v.solid = SOLID_SLIDEBOX;
+			ent->v.flags = FL_MONSTER;
+			break;
+		case 1:
+			ent->v.solid = SOLID_TRIGGER;
+			break;
+		default:
+			ent->v.solid = SOLID_NOT;
+			break;
+		}
+
+		SV_LinkEdict( ent, false );
+		temp[spawned++] = ent;
+	}
+
+	VectorSubtract( sv.worldmodel->maxs, sv.worldmodel->mins, size );
+	areatime = lineartime = 0.0;
+
+	for( i = 0; i < numqueries; i++ )
+	{
+		for( j = 0; j < 3; j++ )
+		{
+			mins[j] = sv.worldmodel->mins[j] + COM_RandomFloat( 0.0f, size[j] );
+			maxs[j] = mins[j] + boxsize;
+		}
+
+		start = Sys_DoubleTime();
+		count1 = SV_AreaEdicts( mins, maxs, list1, sizeof( list1 ) / sizeof( list1[0] ), FL_MONSTER|FL_CLIENT );
+		areatime += Sys_DoubleTime() - start;
+
+		start = Sys_DoubleTime();
+		count2 = SV_LinearEntitiesInBox( mins, maxs, list2, sizeof( list2 ) / sizeof( list2[0] ), FL_MONSTER|FL_CLIENT );
+		lineartime += Sys_DoubleTime() - start;
+
+		if( count1 != count2 || memcmp( list1, list2, count1 * sizeof( edict_t* )))
+			mismatches++;
+	}
+
+	for( i = 0; i < spawned; i++ )
+		SV_FreeEdict( temp[i] );
+	COM_SetRandomSeed( 0 );
+	Mem_Free( temp );
+
+	Msg( "%i queries of %g units box over %i entities (%i temporary)\n", numqueries, boxsize, pfnNumberOfEntities() + spawned, spawned );
+	Msg( "area tree: %.2f msec, linear scan: %.2f msec\n", areatime * 1000.0, lineartime * 1000.0 );
+	if( mismatches ) Msg( "^1%i queries returned different entities^7 (entity was moved without relinking?)\n", mismatches );
+}
+
 /*
 ==================
 SV_InitHostCommands
@@ -1023,6 +1179,8 @@ void SV_InitOperatorCommands( void )
 	Cmd_AddCommand( "entpatch", SV_EntPatch_f, "write entity patch to allow external editing" );
 	Cmd_AddCommand( "edict_usage", SV_EdictUsage_f, "show info about edicts usage" );
 	Cmd_AddCommand( "entity_info", SV_EntityInfo_f, "show more info about edicts" );
+	Cmd_AddCommand( "sv_multicast_stats", SV_MulticastStats_f, "show unreliable multicast copying statistics, 'reset' to clear" );
+	Cmd_AddCommand( "sv_areabench", SV_AreaBench_f, "time entities in box queries with <numents> <boxsize> entities scene" );
 
 	if( host.type == HOST_NORMAL )
 	{
@@ -1031,6 +1189,7 @@ void SV_InitOperatorCommands( void )
 		Cmd_AddCommand( "save", SV_Save_f, "save the game to a file" );
 		Cmd_AddCommand( "savequick", SV_QuickSave_f, "save the game to the quicksave" );
 		Cmd_AddCommand( "autosave", SV_AutoSave_f, "save the game to 'autosave' file" );
+		Cmd_AddCommand( "saveinfo", SV_SaveInfo_f, "show raw and stored size of level files and their load time" );
 	}
 	else if( host.type == HOST_DEDICATED )
 	{
@@ -1059,6 +1218,8 @@ void SV_KillOperatorCommands( void )
 	Cmd_RemoveCommand( "entpatch" );
 	Cmd_RemoveCommand( "edict_usage" );
 	Cmd_RemoveCommand( "entity_info" );
+	Cmd_RemoveCommand( "sv_multicast_stats" );
+	Cmd_RemoveCommand( "sv_areabench" );
 
 	if( host.type == HOST_NORMAL )
 	{
@@ -1068,6 +1229,7 @@ void SV_KillOperatorCommands( void )
 		Cmd_RemoveCommand( "savequick" );
 		Cmd_RemoveCommand( "killsave" );
 		Cmd_RemoveCommand( "autosave" );
+		Cmd_RemoveCommand( "saveinfo" );
 	}
 	else if( host.type == HOST_DEDICATED )
 	{
@@ -87,13 +87,16 @@ static void SV_AddEntitiesToPacket( edict_t *pViewEnt, edict_t *pClient, client_
 		cl->num_viewents = 0;
 	}
 
+	SV_BeginPhase( SVP_SETUPVISIBILITY );
 	svgame.dllFuncs.pfnSetupVisibility( pViewEnt, pClient, &clientpvs, &clientphs );
+	SV_EndPhase( SVP_SETUPVISIBILITY );
 	if( !clientpvs ) fullvis = true;
 
 	// don't send the world
 	for( e = 1; e < svgame.numEntities; e++ )
 	{
 		byte	*pset;
+		int	added;
 
 		ent = EDICT_NUM( e );
 
@@ -112,7 +115,11 @@ static void SV_AddEntitiesToPacket( edict_t *pViewEnt, edict_t *pClient, client_
 		netclient = SV_ClientFromEdict( ent, true );
 
 		// add entity to the net packet
-		if( svgame.dllFuncs.pfnAddToFullPack( state, e, ent, pClient, sv.hostflags, ( netclient != NULL ), pset ))
+		SV_BeginPhase( SVP_ADDTOFULLPACK );
+		added = svgame.dllFuncs.pfnAddToFullPack( state, e, ent, pClient, sv.hostflags, ( netclient != NULL ), pset );
+		SV_EndPhase( SVP_ADDTOFULLPACK );
+
+		if( added )
 		{
 			// to prevent adds it twice through portals
 			SETVISBIT( ents->sended, e );
@@ -486,7 +493,9 @@ void SV_WriteClientdataToMessage( sv_client_t *cl, sizebuf_t *msg )
 	memset( &frame->clientdata, 0, sizeof( frame->clientdata ));
 
 	// update clientdata_t
+	SV_BeginPhase( SVP_UPDATECLIENTDATA );
 	svgame.dllFuncs.pfnUpdateClientData( clent, FBitSet( cl->flags, FCL_LOCAL_WEAPONS ), &frame->clientdata );
+	SV_EndPhase( SVP_UPDATECLIENTDATA );
 
 	MSG_BeginServerCmd( msg, svc_clientdata );
 	if( FBitSet( cl->flags, FCL_HLTV_PROXY )) return;	// don't send more nothing
@@ -606,6 +615,151 @@ FRAME UPDATES
 
 ===============================================================================
 */
+/*
+=======================
+SV_StoreMulticast
+
+copy unreliable payload into shared arena,
+returns -1 if arena is full
+=======================
+*/
+int SV_StoreMulticast( sizebuf_t *msg )
+{
+	int		numbytes = PAD_NUMBER( MSG_GetNumBytesWritten( msg ), 4 );
+	sv_multicast_t	*payload;
+
+	if( svs.num_multicasts >= MAX_MULTICAST_PAYLOADS )
+		return -1;
+
+	if( svs.multicast_arena_used + numbytes > MULTICAST_ARENA_SIZE )
+		return -1;
+
+	payload = &svs.multicasts[svs.num_multicasts];
+	payload->offset = svs.multicast_arena_used;
+	payload->numbits = MSG_GetNumBitsWritten( msg );
+	payload->refcount = 0;
+
+	memcpy( svs.multicast_arena + payload->offset, MSG_GetData( msg ), MSG_GetNumBytesWritten( msg ));
+	svs.multicast_arena_used += numbytes;
+
+	svs.mcast_frame.payloads++;
+	svs.mcast_frame.stored_bytes += MSG_GetNumBytesWritten( msg );
+
+	return svs.num_multicasts++;
+}
+
+/*
+=======================
+SV_ReleaseClientMulticasts
+
+drop all payload references
+=======================
+*/
+void SV_ReleaseClientMulticasts( sv_client_t *cl )
+{
+	int	i;
+
+	for( i = 0; i < cl->num_multicasts; i++ )
+		svs.multicasts[cl->multicasts[i]].refcount--;
+
+	cl->num_multicasts = 0;
+	cl->multicast_bits = 0;
+}
+
+/*
+=======================
+SV_WriteClientMulticasts
+
+splice referenced payloads into message
+=======================
+*/
+static void SV_WriteClientMulticasts( sv_client_t *cl, sizebuf_t *msg )
+{
+	sv_multicast_t	*payload;
+	int		i;
+
+	for( i = 0; i < cl->num_multicasts; i++ )
+	{
+		payload = &svs.multicasts[cl->multicasts[i]];
+		MSG_WriteBits( msg, svs.multicast_arena + payload->offset, payload->numbits );
+		svs.mcast_frame.copied_bytes += BitByte( payload->numbits );
+	}
+
+	SV_ReleaseClientMulticasts( cl );
+}
+
+/*
+=======================
+SV_LinkMulticast
+
+add unreliable payload to the client datagram
+=======================
+*/
+void SV_LinkMulticast( sv_client_t *cl, int payload, sizebuf_t *msg )
+{
+	int	numbits = MSG_GetNumBitsWritten( msg );
+
+	// the datagram has the same size limit as before
+	if( MSG_GetNumBitsWritten( &cl->datagram ) + cl->multicast_bits + numbits > MSG_GetMaxBits( &cl->datagram ))
+	{
+		cl->datagram.bOverflow = true;
+		return;
+	}
+
+	svs.mcast_frame.percopy_bytes += BitByte( numbits ) * 2;
+
+	if( payload == -1 || cl->num_multicasts >= MAX_CLIENT_MULTICASTS )
+	{
+		// no room for reference, fallback to copy
+		// but keep the order of the messages
+		SV_WriteClientMulticasts( cl, &cl->datagram );
+		MSG_WriteBits( &cl->datagram, MSG_GetData( msg ), numbits );
+		svs.mcast_frame.copied_bytes += BitByte( numbits );
+		return;
+	}
+
+	cl->multicasts[cl->num_multicasts++] = payload;
+	cl->multicast_bits += numbits;
+	svs.multicasts[payload].refcount++;
+	svs.mcast_frame.references++;
+}
+
+/*
+=======================
+SV_ClearMulticasts
+
+called at end of frame, clients that doesn't
+send a datagram get own copy of their payloads
+=======================
+*/
+void SV_ClearMulticasts( void )
+{
+	sv_mcaststats_t	*total = &svs.mcast_total;
+	sv_mcaststats_t	*frame = &svs.mcast_frame;
+	sv_client_t	*cl;
+	int		i;
+
+	for( i = 0, cl = svs.clients; svs.clients && i < svs.maxclients; i++, cl++ )
+	{
+		if( !cl->num_multicasts ) continue;
+
+		if( cl->state >= cs_connected && !MSG_CheckOverflow( &cl->datagram ))
+			SV_WriteClientMulticasts( cl, &cl->datagram );
+		else SV_ReleaseClientMulticasts( cl );
+	}
+
+	total->payloads += frame->payloads;
+	total->references += frame->references;
+	total->stored_bytes += frame->stored_bytes;
+	total->copied_bytes += frame->copied_bytes;
+	total->percopy_bytes += frame->percopy_bytes;
+	svs.mcast_frames++;
+
+	memset( frame, 0, sizeof( *frame ));
+	svs.multicast_arena_used = 0;
+	svs.num_multicasts = 0;
+}
+
 /*
 =======================
 SV_SendClientDatagram
@@ -645,11 +799,16 @@ void SV_SendClientDatagram( sv_client_t *cl )
 	}
 	else
 	{
-		if( MSG_GetNumBytesWritten( &cl->datagram ) < MSG_GetNumBytesLeft( &msg ))
+		if( BitByte( MSG_GetNumBitsWritten( &cl->datagram ) + cl->multicast_bits ) < MSG_GetNumBytesLeft( &msg ))
+		{
 			MSG_WriteBits( &msg, MSG_GetData( &cl->datagram ), MSG_GetNumBitsWritten( &cl->datagram ));
+			svs.mcast_frame.copied_bytes += MSG_GetNumBytesWritten( &cl->datagram );
+			SV_WriteClientMulticasts( cl, &msg );
+		}
 		else MsgDev( D_WARN, "Ignoring unreliable datagram for %s, would overflow on msg\n", cl->name );
 	}
 
+	SV_ReleaseClientMulticasts( cl );
 	MSG_Clear( &cl->datagram );
 
 	if( MSG_CheckOverflow( &msg ))
@@ -663,6 +822,18 @@ void SV_SendClientDatagram( sv_client_t *cl )
 	Netchan_TransmitBits( &cl->netchan, MSG_GetNumBitsWritten( &msg ), MSG_GetData( &msg ));
 }
 
+/*
+=======================
+SV_DatagramBytesLeft
+
+including shared payloads
+=======================
+*/
+static int SV_DatagramBytesLeft( sv_client_t *cl )
+{
+	return ( MSG_GetNumBitsLeft( &cl->datagram ) - cl->multicast_bits ) >> 3;
+}
+
 /*
 =======================
 SV_UpdateUserInfo
@@ -682,6 +853,8 @@ SV_UpdateToReliableMessages
 */
 void SV_UpdateToReliableMessages( void )
 {
+	int		datagram = -2;		// not stored yet
+	int		spec_datagram = -2;
 	sv_client_t	*cl;
 	int		i;
 
@@ -745,20 +918,25 @@ void SV_UpdateToReliableMessages( void )
 			Netchan_CreateFragments( &cl->netchan, &sv.reliable_datagram );
 		}
 
-		if( MSG_GetNumBytesWritten( &sv.datagram ) < MSG_GetNumBytesLeft( &cl->datagram ))
-		{
-			MSG_WriteBits( &cl->datagram, MSG_GetBuf( &sv.datagram ), MSG_GetNumBitsWritten( &sv.datagram ));
-		}
-		else
+		if( MSG_GetNumBitsWritten( &sv.datagram ))
 		{
-			MsgDev( D_WARN, "Ignoring unreliable datagram for %s, would overflow\n", cl->name );
+			if( MSG_GetNumBytesWritten( &sv.datagram ) < SV_DatagramBytesLeft( cl ))
+			{
+				if( datagram == -2 ) datagram = SV_StoreMulticast( &sv.datagram );
+				SV_LinkMulticast( cl, datagram, &sv.datagram );
+			}
+			else
+			{
+				MsgDev( D_WARN, "Ignoring unreliable datagram for %s, would overflow\n", cl->name );
+			}
 		}
 
-		if( FBitSet( cl->flags, FCL_HLTV_PROXY ))
+		if( FBitSet( cl->flags, FCL_HLTV_PROXY ) && MSG_GetNumBitsWritten( &sv.spec_datagram ))
 		{
-			if( MSG_GetNumBytesWritten( &sv.spec_datagram ) < MSG_GetNumBytesLeft( &cl->datagram ))
+			if( MSG_GetNumBytesWritten( &sv.spec_datagram ) < SV_DatagramBytesLeft( cl ))
 			{
-				MSG_WriteBits( &cl->datagram, MSG_GetBuf( &sv.spec_datagram ), MSG_GetNumBitsWritten( &sv.spec_datagram ));
+				if( spec_datagram == -2 ) spec_datagram = SV_StoreMulticast( &sv.spec_datagram );
+				SV_LinkMulticast( cl, spec_datagram, &sv.spec_datagram );
 			}
 			else
 			{
@@ -820,6 +998,7 @@ void SV_SendClientMessages( void )
 		{
 			MSG_Clear( &cl->netchan.message );
 			MSG_Clear( &cl->datagram );
+			SV_ReleaseClientMulticasts( cl );
 			SV_BroadcastPrintf( NULL, PRINT_HIGH, "%s overflowed\n", cl->name );
 			MsgDev( D_WARN, "reliable overflow for %s\n", cl->name );
 			SV_DropClient( cl );
@@ -857,6 +1036,9 @@ void SV_SendClientMessages( void )
 		}
 	}
 
+	// free shared payloads for next frame
+	SV_ClearMulticasts();
+
 	// reset current client
 	svs.currentPlayer = NULL;
 	svs.currentPlayerNum = -1;
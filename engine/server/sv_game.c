@@ -284,6 +284,7 @@ int SV_Multicast( int dest, const vec3_t origin, const edict_t *ent, qboolean us
 	sv_client_t	*cl, *current = svs.clients;
 	qboolean		reliable = false;
 	qboolean		specproxy = false;
+	int		payload = -2;	// not stored yet
 	int		numsends = 0;
 
 	switch( dest )
@@ -368,7 +369,12 @@ int SV_Multicast( int dest, const vec3_t origin, const edict_t *ent, qboolean us
 
 		if( specproxy ) MSG_WriteBits( &sv.spec_datagram, MSG_GetData( &sv.multicast ), MSG_GetNumBitsWritten( &sv.multicast ));
 		else if( reliable ) MSG_WriteBits( &cl->netchan.message, MSG_GetData( &sv.multicast ), MSG_GetNumBitsWritten( &sv.multicast ));
-		else MSG_WriteBits( &cl->datagram, MSG_GetData( &sv.multicast ), MSG_GetNumBitsWritten( &sv.multicast ));
+		else
+		{
+			// unreliable payload is stored once and spliced into each datagram
+			if( payload == -2 ) payload = SV_StoreMulticast( &sv.multicast );
+			SV_LinkMulticast( cl, payload, &sv.multicast );
+		}
 		numsends++;
 	}
 
@@ -799,6 +805,7 @@ void SV_InitEdict( edict_t *pEdict )
 
 	pEdict->v.pContainingEntity = pEdict; // make cross-links for consistency
 	pEdict->free = false;
+	SV_WakeEdict( pEdict );
 }
 
 void SV_FreeEdict( edict_t *pEdict )
@@ -2494,14 +2501,10 @@ void pfnMessageBegin( int msg_dest, int msg_num, const float *pOrigin, edict_t *
 	}
 	else
 	{
-		// check for existing
-		for( i = 1; i < MAX_USER_MESSAGES && svgame.msg[i].name[0]; i++ )
-		{
-			if( svgame.msg[i].number == msg_num )
-				break; // found
-		}
+		// user messages are registered in order, so number is an index
+		i = msg_num - svc_lastmsg;
 
-		if( i == MAX_USER_MESSAGES )
+		if( i >= MAX_USER_MESSAGES || !svgame.msg[i].name[0] )
 		{
 			Host_Error( "MessageBegin: tried to send unregistered message %i\n", msg_num );
 			return;
@@ -3226,7 +3229,16 @@ pfnFunctionFromName
 */
 dword pfnFunctionFromName( const char *pName )
 {
-	return Com_FunctionFromName( svgame.hInstance, pName );
+	double	start = Sys_DoubleTime();
+	dword	function;
+
+	function = Com_FunctionFromName( svgame.hInstance, pName );
+
+	// restore statistics
+	svgame.funcLookupTime += Sys_DoubleTime() - start;
+	svgame.numFuncLookups++;
+
+	return function;
 }
 
 /*
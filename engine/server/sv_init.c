@@ -519,6 +519,7 @@ qboolean SV_SpawnServer( const char *mapname, const char *startspot )
 	sv.state = ss_dead;
 	Host_SetServerState( sv.state );
 	memset( &sv, 0, sizeof( sv ));	// wipe the entire per-level structure
+	SV_ClearUnlagHistory ();
 
 	// restore state
 	sv.paused = paused;
@@ -644,6 +645,8 @@ void SV_InitGame( void )
 	svgame.globals->maxClients = svs.maxclients;
 
 	svs.clients = Z_Malloc( sizeof( sv_client_t ) * svs.maxclients );
+	memset( svs.clienthash, 0, sizeof( svs.clienthash ));
+	SV_ClearMulticasts();
 	svs.num_client_entities = svs.maxclients * SV_UPDATE_BACKUP * NUM_PACKET_ENTITIES;
 	svs.packet_entities = Z_Malloc( sizeof( entity_state_t ) * svs.num_client_entities );
 	svs.baselines = Z_Malloc( sizeof( entity_state_t ) * GI->max_edicts );
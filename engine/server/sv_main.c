@@ -38,6 +38,9 @@ CVAR_DEFINE_AUTO( sv_minrate, "0", FCVAR_SERVER, "min bandwidth rate allowed on
 CVAR_DEFINE_AUTO( sv_maxrate, "0", FCVAR_SERVER, "max bandwidth rate allowed on server, 0 == unlimited" );
 CVAR_DEFINE_AUTO( sv_logrelay, "0", FCVAR_ARCHIVE, "allow log messages from remote machines to be logged on this server" );
 CVAR_DEFINE_AUTO( sv_newunit, "0", 0, "clear level-saves from previous SP game chapter to help keep .sav file size as minimum" );
+CVAR_DEFINE_AUTO( sv_skipidle, "1", 0, "don't run physics for static entities which are not going to think at this frame" );
+CVAR_DEFINE_AUTO( sv_sleepents, "1", 0, "entities at rest are sleeping until they are touched, moved or going to think" );
+CVAR_DEFINE_AUTO( sv_physthreads, "0", 0, "number of threads to trace moves of tossed entities, 0 = disabled, 1 = main thread only, moves out of reach of other entities are finished at end of frame" );
 CVAR_DEFINE_AUTO( sv_clienttrace, "1", FCVAR_SERVER, "0 = big box(Quake), 0.5 = halfsize, 1 = normal (100%), otherwise it's a scaling factor" );
 CVAR_DEFINE_AUTO( sv_timeout, "65", 0, "after this many seconds without a message from a client, the client is dropped" );
 CVAR_DEFINE_AUTO( sv_failuretime, "0.5", 0, "after this long without a packet from client, don't send any more until client starts sending again" );
@@ -260,6 +263,109 @@ void SV_CheckCmdTimes( void )
 	}
 }
 
+/*
+=================
+SV_ClientHashKey
+
+port is not a part of the key
+because routers may translate it
+=================
+*/
+static uint SV_ClientHashKey( const netadr_t *adr, int qport )
+{
+	uint	hash = qport;
+	int	i;
+
+	if( adr->type == NA_IP )
+	{
+		hash ^= (adr->ip[0]<<24)|(adr->ip[1]<<16)|(adr->ip[2]<<8)|adr->ip[3];
+	}
+	else if( adr->type == NA_IPX )
+	{
+		for( i = 0; i < 10; i++ )
+			hash = ( hash * 31 ) + adr->ipx[i];
+	}
+
+	hash ^= ( hash >> 16 );
+	hash ^= ( hash >> 8 );
+
+	return hash & (SV_CLIENT_HASH_SIZE - 1);
+}
+
+/*
+=================
+SV_LinkClientAddress
+
+must be called after Netchan_Setup
+=================
+*/
+void SV_LinkClientAddress( sv_client_t *cl )
+{
+	uint	hash;
+
+	if( FBitSet( cl->flags, FCL_FAKECLIENT ))
+		return;	// fake clients never send packets
+
+	SV_UnlinkClientAddress( cl );
+
+	hash = SV_ClientHashKey( &cl->netchan.remote_address, cl->netchan.qport );
+	cl->hashnext = svs.clienthash[hash];
+	svs.clienthash[hash] = cl;
+}
+
+/*
+=================
+SV_UnlinkClientAddress
+
+must be called before client slot is reused
+=================
+*/
+void SV_UnlinkClientAddress( sv_client_t *cl )
+{
+	sv_client_t	**prev;
+	int		i;
+
+	// address may be already overwritten, so search all chains
+	for( i = 0; i < SV_CLIENT_HASH_SIZE; i++ )
+	{
+		for( prev = &svs.clienthash[i]; *prev; prev = &(*prev)->hashnext )
+		{
+			if( *prev == cl )
+			{
+				*prev = cl->hashnext;
+				cl->hashnext = NULL;
+				return;
+			}
+		}
+	}
+}
+
+/*
+=================
+SV_ClientFromAddress
+
+find connected client that sent the packet
+=================
+*/
+static sv_client_t *SV_ClientFromAddress( netadr_t from, int qport )
+{
+	sv_client_t	*cl;
+
+	for( cl = svs.clienthash[SV_ClientHashKey( &from, qport )]; cl; cl = cl->hashnext )
+	{
+		if( cl->state == cs_free || FBitSet( cl->flags, FCL_FAKECLIENT ))
+			continue;
+
+		if( cl->netchan.qport != qport )
+			continue;
+
+		if( NET_CompareBaseAdr( from, cl->netchan.remote_address ))
+			return cl;
+	}
+
+	return NULL;
+}
+
 /*
 =================
 SV_ReadPackets
@@ -268,7 +374,7 @@ SV_ReadPackets
 void SV_ReadPackets( void )
 {
 	sv_client_t	*cl;
-	int		i, qport;
+	int		qport;
 	size_t		curSize;
 
 	while( NET_GetPacket( NS_SERVER, &net_from, net_message_buffer, &curSize ))
@@ -305,17 +411,8 @@ void SV_ReadPackets( void )
 		qport = (int)MSG_ReadShort( &net_message ) & 0xffff;
 
 		// check for packets from connected clients
-		for( i = 0, cl = svs.clients; i < svs.maxclients; i++, cl++ )
+		if(( cl = SV_ClientFromAddress( net_from, qport )) != NULL )
 		{
-			if( cl->state == cs_free || FBitSet( cl->flags, FCL_FAKECLIENT ))
-				continue;
-
-			if( !NET_CompareBaseAdr( net_from, cl->netchan.remote_address ))
-				continue;
-
-			if( cl->netchan.qport != qport )
-				continue;
-
 			if( cl->netchan.remote_address.port != net_from.port )
 			{
 				MsgDev( D_NOTE, "SV_ReadPackets: fixing up a translated port\n");
@@ -336,6 +433,12 @@ void SV_ReadPackets( void )
 					svgame.globals->time = sv.time;
 				}
 			}
+			else if( cl->netchan.bad_fragments >= NET_MAX_BAD_FRAGMENTS && cl->state != cs_zombie )
+			{
+				SV_BroadcastPrintf( NULL, PRINT_HIGH, "%s sent malformed data\n", cl->name );
+				SV_DropClient( cl );
+				continue;
+			}
 
 			// fragmentation/reassembly sending takes priority over all game messages, want this in the future?
 			if( Netchan_IncomingReady( &cl->netchan ))
@@ -362,11 +465,7 @@ void SV_ReadPackets( void )
 					SV_ProcessFile( cl, cl->netchan.incomingfilename );
 				}
 			}
-			break;
 		}
-
-		if( i != svs.maxclients )
-			continue;
 	}
 
 	svs.currentPlayer = NULL;
@@ -414,6 +513,7 @@ void SV_CheckTimeouts( void )
 
 		if( cl->state == cs_zombie && cl->lastmessage < zombiepoint )
 		{
+			SV_UnlinkClientAddress( cl );
 			cl->state = cs_free; // can now be reused
 			continue;
 		}
@@ -424,6 +524,7 @@ void SV_CheckTimeouts( void )
 			{
 				SV_BroadcastPrintf( NULL, PRINT_HIGH, "%s timed out\n", cl->name );
 				SV_DropClient( cl ); 
+				SV_UnlinkClientAddress( cl );
 				cl->state = cs_free; // don't bother with zombie state
 			}
 		}
@@ -545,35 +646,57 @@ void Host_ServerFrame( void )
 	// if server is not active, do nothing
 	if( !svs.initialized ) return;
 
+	// release savegame when worker is done
+	SV_FinishSaveGame( false );
+
 	if( FBitSet( host.features, ENGINE_FIXED_FRAMERATE ))
 		sv.frametime = ( 1.0 / (double)GAME_FPS );
 	else sv.frametime = host.frametime; // GoldSrc style
 
 	svgame.globals->frametime = sv.frametime;
 
+	SV_ProfileFrameBegin ();
+
 	// check clients timewindow
 	SV_CheckCmdTimes ();
 
 	// read packets from clients
+	SV_BeginPhase( SVP_READPACKETS );
 	SV_ReadPackets ();
+	SV_EndPhase( SVP_READPACKETS );
 
 	// refresh physic movevars on the client side
 	SV_UpdateMovevars ( false );
 
 	// check timeouts
+	SV_BeginPhase( SVP_TIMEOUTS );
 	SV_CheckTimeouts ();
+	SV_EndPhase( SVP_TIMEOUTS );
 
 	// let everything in the world think and move
+	SV_BeginPhase( SVP_GAMEFRAME );
 	SV_RunGameFrame ();
+	SV_EndPhase( SVP_GAMEFRAME );
+
+	// remember positions for lag compensation
+	SV_RecordUnlagHistory ();
 		
 	// send messages back to the clients that had packets read this frame
+	SV_BeginPhase( SVP_SENDMESSAGES );
 	SV_SendClientMessages ();
+	SV_EndPhase( SVP_SENDMESSAGES );
 
 	// clear edict flags for next frame
+	SV_BeginPhase( SVP_PREPWORLD );
 	SV_PrepWorldFrame ();
+	SV_EndPhase( SVP_PREPWORLD );
 
 	// send a heartbeat to the master if needed
+	SV_BeginPhase( SVP_HEARTBEAT );
 	Master_Heartbeat ();
+	SV_EndPhase( SVP_HEARTBEAT );
+
+	SV_ProfileFrameEnd ();
 }
 
 //============================================================================
@@ -743,6 +866,10 @@ void SV_Init( void )
 	Cvar_RegisterVariable (&rcon_password);
 	Cvar_RegisterVariable (&sv_stepsize);
 	Cvar_RegisterVariable (&sv_newunit);
+	Cvar_RegisterVariable (&sv_save_compress);
+	Cvar_RegisterVariable (&sv_skipidle);
+	Cvar_RegisterVariable (&sv_sleepents);
+	Cvar_RegisterVariable (&sv_physthreads);
 	hostname = Cvar_Get( "hostname", "unnamed", FCVAR_SERVER|FCVAR_ARCHIVE, "host name" );
 	timeout = Cvar_Get( "timeout", "125", FCVAR_SERVER, "connection timeout" );
 	zombietime = Cvar_Get( "zombietime", "2", FCVAR_SERVER, "timeout for clients-zombie (who died but not respawned)" );
@@ -790,6 +917,8 @@ void SV_Init( void )
 	Cvar_RegisterVariable (&violence_agibs);
 	Cvar_RegisterVariable (&violence_hgibs);
 
+	SV_InitProfiler ();
+
 	// when we in developer-mode automatically turn cheats on
 	if( host.developer > 1 ) Cvar_SetValue( "sv_cheats", 1.0f );
 
@@ -853,12 +982,18 @@ before Sys_Quit or Sys_Error
 */
 void SV_Shutdown( qboolean reconnect )
 {
+	// savegame must be completed before quit
+	SV_FinishSaveGame( true );
+
 	// already freed
 	if( !SV_Active( )) return;
 
 	// rcon will be disconnected
 	SV_EndRedirect();
 
+	SV_ShutdownProfiler();
+	SV_StopPhysicsThreads();
+
 	if( host.type == HOST_DEDICATED )
 		MsgDev( D_INFO, "SV_Shutdown: %s\n", host.finalmsg );
 
@@ -878,7 +1013,9 @@ void SV_Shutdown( qboolean reconnect )
 	// free server static data
 	if( svs.clients )
 	{
+		SV_ClearMulticasts();
 		Z_Free( svs.clients );
+		memset( svs.clienthash, 0, sizeof( svs.clienthash ));
 		svs.clients = NULL;
 	}
 
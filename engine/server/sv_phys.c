@@ -214,7 +214,9 @@ qboolean SV_RunThink( edict_t *ent )
 						// by a trigger with a local time.
 		ent->v.nextthink = 0.0f;
 		svgame.globals->time = thinktime;
+		SV_BeginPhase( SVP_THINK );
 		svgame.dllFuncs.pfnThink( ent );
+		SV_EndPhase( SVP_THINK );
 	}
 
 	if( FBitSet( ent->v.flags, FL_KILLME ))
@@ -253,7 +255,9 @@ qboolean SV_PlayerRunThink( edict_t *ent, float frametime, double time )
 
 		ent->v.nextthink = 0.0f;
 		svgame.globals->time = thinktime;
+		SV_BeginPhase( SVP_THINK );
 		svgame.dllFuncs.pfnThink( ent );
+		SV_EndPhase( SVP_THINK );
 	}
 
 	if( FBitSet( ent->v.flags, FL_KILLME ))
@@ -279,6 +283,9 @@ void SV_Impact( edict_t *e1, edict_t *e2, trace_t *trace )
 	if(( e1->v.flags|e2->v.flags ) & FL_KILLME )
 		return;
 
+	SV_WakeEdict( e1 );
+	SV_WakeEdict( e2 );
+
 	if( e1->v.groupinfo && e2->v.groupinfo )
 	{
 		if(( !svs.groupop && !( e1->v.groupinfo & e2->v.groupinfo )) ||
@@ -289,13 +296,17 @@ void SV_Impact( edict_t *e1, edict_t *e2, trace_t *trace )
 	if( e1->v.solid != SOLID_NOT )
 	{
 		SV_CopyTraceToGlobal( trace );
+		SV_BeginPhase( SVP_TOUCH );
 		svgame.dllFuncs.pfnTouch( e1, e2 );
+		SV_EndPhase( SVP_TOUCH );
 	}
 
 	if( e2->v.solid != SOLID_NOT )
 	{
 		SV_CopyTraceToGlobal( trace );
+		SV_BeginPhase( SVP_TOUCH );
 		svgame.dllFuncs.pfnTouch( e2, e1 );
+		SV_EndPhase( SVP_TOUCH );
 	}
 }
 
@@ -779,32 +790,33 @@ qboolean SV_AllowPushRotate( edict_t *ent )
 
 /*
 ============
-SV_PushEntity
+SV_PushMoveType
 
-Does not change the entities velocity at all
+what the pushed entity should clip against
 ============
 */
-trace_t SV_PushEntity( edict_t *ent, const vec3_t lpush, const vec3_t apush, int *blocked, float flDamage )
+static int SV_PushMoveType( edict_t *ent )
 {
-	trace_t	trace;
-	qboolean	monsterClip;
-	int	type;
-	vec3_t	end;
-
-	monsterClip = FBitSet( ent->v.flags, FL_MONSTERCLIP ) ? true : false;
-	VectorAdd( ent->v.origin, lpush, end );
-
 	if( ent->v.movetype == MOVETYPE_FLYMISSILE )
-		type = MOVE_MISSILE;
-	else if( ent->v.solid == SOLID_TRIGGER || ent->v.solid == SOLID_NOT )
-		type = MOVE_NOMONSTERS; // only clip against bmodels
-	else type = MOVE_NORMAL;
+		return MOVE_MISSILE;
+	if( ent->v.solid == SOLID_TRIGGER || ent->v.solid == SOLID_NOT )
+		return MOVE_NOMONSTERS; // only clip against bmodels
+	return MOVE_NORMAL;
+}
 
-	trace = SV_Move( ent->v.origin, ent->v.mins, ent->v.maxs, end, type, ent, monsterClip );
+/*
+============
+SV_FinishPush
 
-	if( trace.fraction != 0.0f )
+move entity to the end of trace, link it
+and run impact functions
+============
+*/
+static void SV_FinishPush( edict_t *ent, trace_t *trace, const vec3_t end, const vec3_t apush, int *blocked, float flDamage )
+{
+	if( trace->fraction != 0.0f )
 	{
-		VectorCopy( trace.endpos, ent->v.origin );
+		VectorCopy( trace->endpos, ent->v.origin );
 
 		if( sv.state == ss_active && apush[YAW] && ( ent->v.flags & FL_CLIENT ))
 		{
@@ -814,7 +826,7 @@ trace_t SV_PushEntity( edict_t *ent, const vec3_t lpush, const vec3_t apush, int
 
 		// don't rotate pushables!
 		if( SV_AllowPushRotate( ent ))
-			ent->v.angles[YAW] += trace.fraction * apush[YAW];
+			ent->v.angles[YAW] += trace->fraction * apush[YAW];
 	}
 
 	SV_LinkEdict( ent, true );
@@ -828,8 +840,28 @@ trace_t SV_PushEntity( edict_t *ent, const vec3_t lpush, const vec3_t apush, int
 	}
 
 	// so we can run impact function afterwards.
-	if( SV_IsValidEdict( trace.ent ))
-		SV_Impact( ent, trace.ent, &trace );
+	if( SV_IsValidEdict( trace->ent ))
+		SV_Impact( ent, trace->ent, trace );
+}
+
+/*
+============
+SV_PushEntity
+
+Does not change the entities velocity at all
+============
+*/
+trace_t SV_PushEntity( edict_t *ent, const vec3_t lpush, const vec3_t apush, int *blocked, float flDamage )
+{
+	trace_t	trace;
+	qboolean	monsterClip;
+	vec3_t	end;
+
+	monsterClip = FBitSet( ent->v.flags, FL_MONSTERCLIP ) ? true : false;
+	VectorAdd( ent->v.origin, lpush, end );
+
+	trace = SV_Move( ent->v.origin, ent->v.mins, ent->v.maxs, end, SV_PushMoveType( ent ), ent, monsterClip );
+	SV_FinishPush( ent, &trace, end, apush, blocked, flDamage );
 
 	return trace;
 }
@@ -1191,7 +1223,12 @@ void SV_Physics_Pusher( edict_t *ent )
 
 	// if the pusher has a "blocked" function, call it
 	// otherwise, just stay in place until the obstacle is gone
-	if( pBlocker ) svgame.dllFuncs.pfnBlocked( ent, pBlocker );
+	if( pBlocker )
+	{
+		SV_BeginPhase( SVP_BLOCKED );
+		svgame.dllFuncs.pfnBlocked( ent, pBlocker );
+		SV_EndPhase( SVP_BLOCKED );
+	}
 
 	for( i = 0; i < 3; i++ )
 	{
@@ -1203,7 +1240,9 @@ void SV_Physics_Pusher( edict_t *ent )
 	{
 		ent->v.nextthink = 0.0f;
 		svgame.globals->time = sv.time;
+		SV_BeginPhase( SVP_THINK );
 		svgame.dllFuncs.pfnThink( ent );
+		SV_EndPhase( SVP_THINK );
 	}
 }
 
@@ -1419,6 +1458,81 @@ void SV_CheckWaterTransition( edict_t *ent )
 	ent->v.waterlevel = 3;
 }
 
+/*
+=============
+SV_FinishTossMove
+
+bounce or stop after the move was done
+=============
+*/
+static void SV_FinishTossMove( edict_t *ent, trace_t *pushtrace )
+{
+	trace_t	trace = *pushtrace;
+	vec3_t	move;
+	float	backoff;
+
+	if( ent->free ) return;
+
+	SV_CheckVelocity( ent );
+
+	if( trace.allsolid )
+	{
+		// entity is trapped in another solid
+		VectorClear( ent->v.avelocity );
+		VectorClear( ent->v.velocity );
+		return;
+	}
+
+	if( trace.fraction == 1.0f )
+	{
+		SV_CheckWaterTransition( ent );
+		return;
+	}
+
+	if( ent->v.movetype == MOVETYPE_BOUNCE )
+		backoff = 2.0f - ent->v.friction;
+	else if( ent->v.movetype == MOVETYPE_BOUNCEMISSILE )
+		backoff = 2.0f;
+	else backoff = 1.0f;
+
+	SV_ClipVelocity( ent->v.velocity, trace.plane.normal, ent->v.velocity, backoff );
+
+	// stop if on ground
+	if( trace.plane.normal[2] > 0.7f )
+	{		
+		float	vel;
+
+		VectorAdd( ent->v.velocity, ent->v.basevelocity, move );
+		vel = DotProduct( move, move );
+
+		if( ent->v.velocity[2] < sv_gravity.value * sv.frametime )
+		{
+			// we're rolling on the ground, add static friction.
+			ent->v.groundentity = trace.ent;
+			ent->v.flags |= FL_ONGROUND;
+			ent->v.velocity[2] = 0.0f;
+		}
+
+		if( vel < 900.0f || ( ent->v.movetype != MOVETYPE_BOUNCE && ent->v.movetype != MOVETYPE_BOUNCEMISSILE ))
+		{
+			ent->v.flags |= FL_ONGROUND;
+			ent->v.groundentity = trace.ent;
+			VectorClear( ent->v.avelocity );
+			VectorClear( ent->v.velocity );
+		}
+		else
+		{
+			VectorScale( ent->v.velocity, (1.0f - trace.fraction) * sv.frametime * 0.9f, move );
+			VectorMA( move, (1.0f - trace.fraction) * sv.frametime * 0.9f, ent->v.basevelocity, move );
+			trace = SV_PushEntity( ent, move, vec3_origin, NULL, 0.0f );
+			if( ent->free ) return;
+		}
+	}
+	
+	// check for in water
+	SV_CheckWaterTransition( ent );
+}
+
 /*
 =============
 SV_Physics_Toss
@@ -1430,7 +1544,6 @@ void SV_Physics_Toss( edict_t *ent )
 {
 	trace_t	trace;
 	vec3_t	move;
-	float	backoff;
 	edict_t	*ground;
 
 	SV_CheckWater( ent );
@@ -1491,67 +1604,12 @@ void SV_Physics_Toss( edict_t *ent )
 
 	VectorSubtract( ent->v.velocity, ent->v.basevelocity, ent->v.velocity );
 
-	trace = SV_PushEntity( ent, move, vec3_origin, NULL, 0.0f );
-	if( ent->free ) return;
-
-	SV_CheckVelocity( ent );
-
-	if( trace.allsolid )
-	{
-		// entity is trapped in another solid
-		VectorClear( ent->v.avelocity );
-		VectorClear( ent->v.velocity );
+	// parallel physics will finish the move later
+	if( SV_DeferTossMove( ent, move ))
 		return;
-	}
-
-	if( trace.fraction == 1.0f )
-	{
-		SV_CheckWaterTransition( ent );
-		return;
-	}
-
-	if( ent->v.movetype == MOVETYPE_BOUNCE )
-		backoff = 2.0f - ent->v.friction;
-	else if( ent->v.movetype == MOVETYPE_BOUNCEMISSILE )
-		backoff = 2.0f;
-	else backoff = 1.0f;
-
-	SV_ClipVelocity( ent->v.velocity, trace.plane.normal, ent->v.velocity, backoff );
-
-	// stop if on ground
-	if( trace.plane.normal[2] > 0.7f )
-	{		
-		float	vel;
-
-		VectorAdd( ent->v.velocity, ent->v.basevelocity, move );
-		vel = DotProduct( move, move );
-
-		if( ent->v.velocity[2] < sv_gravity.value * sv.frametime )
-		{
-			// we're rolling on the ground, add static friction.
-			ent->v.groundentity = trace.ent;
-			ent->v.flags |= FL_ONGROUND;
-			ent->v.velocity[2] = 0.0f;
-		}
 
-		if( vel < 900.0f || ( ent->v.movetype != MOVETYPE_BOUNCE && ent->v.movetype != MOVETYPE_BOUNCEMISSILE ))
-		{
-			ent->v.flags |= FL_ONGROUND;
-			ent->v.groundentity = trace.ent;
-			VectorClear( ent->v.avelocity );
-			VectorClear( ent->v.velocity );
-		}
-		else
-		{
-			VectorScale( ent->v.velocity, (1.0f - trace.fraction) * sv.frametime * 0.9f, move );
-			VectorMA( move, (1.0f - trace.fraction) * sv.frametime * 0.9f, ent->v.basevelocity, move );
-			trace = SV_PushEntity( ent, move, vec3_origin, NULL, 0.0f );
-			if( ent->free ) return;
-		}
-	}
-	
-	// check for in water
-	SV_CheckWaterTransition( ent );
+	trace = SV_PushEntity( ent, move, vec3_origin, NULL, 0.0f );
+	SV_FinishTossMove( ent, &trace );
 }
 
 /*
@@ -1709,6 +1767,547 @@ void SV_Physics_None( edict_t *ent )
 	SV_RunThink( ent );
 }
 
+/*
+===============================================================================
+
+SLEEPING ENTITIES
+
+===============================================================================
+*/
+typedef struct
+{
+	qboolean		sleeping;
+	edict_t		*ground;		// ground entity at time we fell asleep
+	vec3_t		groundorigin;
+	vec3_t		groundangles;
+} sv_sleepstate_t;
+
+static sv_sleepstate_t	sv_sleep[MAX_EDICTS];
+
+/*
+=============
+SV_WakeEdict
+
+called when entity is linked, touched
+or was (re)allocated
+=============
+*/
+void SV_WakeEdict( edict_t *ent )
+{
+	sv_sleep[NUM_FOR_EDICT( ent )].sleeping = false;
+}
+
+/*
+=============
+SV_IsResting
+
+entity is not moving and nothing can move it except
+the game dll or another entity
+=============
+*/
+static qboolean SV_IsResting( edict_t *ent )
+{
+	edict_t	*ground;
+
+	switch( ent->v.movetype )
+	{
+	case MOVETYPE_PUSH:
+		// movers at rest, SV_Physics_Pusher only advances ltime
+		if( FBitSet( ent->v.flags, FL_ONGROUND|FL_BASEVELOCITY|FL_KILLME ))
+			return false;
+		return ( VectorIsNull( ent->v.velocity ) && VectorIsNull( ent->v.avelocity ) && VectorIsNull( ent->v.basevelocity ));
+	case MOVETYPE_STEP:
+	case MOVETYPE_PUSHSTEP:
+		// SV_WaterMove changes living monsters and pushables each frame
+		if( !FBitSet( ent->v.flags, FL_MONSTER ) || ent->v.health > 0.0f )
+			return false;
+		break;
+	case MOVETYPE_TOSS:
+	case MOVETYPE_BOUNCE:
+		break;
+	default:
+		return false;
+	}
+
+	if( FBitSet( ent->v.flags, FL_BASEVELOCITY|FL_KILLME ) || !FBitSet( ent->v.flags, FL_ONGROUND ))
+		return false;
+
+	if( ent->v.waterlevel != 0 || !VectorIsNull( ent->v.velocity ) || !VectorIsNull( ent->v.avelocity ) || !VectorIsNull( ent->v.basevelocity ))
+		return false;
+
+	// ground can move, push or carry us
+	ground = ent->v.groundentity;
+
+	if( !SV_IsValidEdict( ground ) || FBitSet( ground->v.flags, FL_MONSTER|FL_CLIENT|FL_CONVEYOR ))
+		return false;
+
+	return true;
+}
+
+/*
+=============
+SV_TryToSleep
+
+park entity which came to rest
+=============
+*/
+static void SV_TryToSleep( edict_t *ent )
+{
+	sv_sleepstate_t	*state = &sv_sleep[NUM_FOR_EDICT( ent )];
+
+	if( !SV_IsResting( ent ))
+		return;
+
+	state->sleeping = true;
+	state->ground = ent->v.groundentity;
+
+	if( state->ground )
+	{
+		VectorCopy( state->ground->v.origin, state->groundorigin );
+		VectorCopy( state->ground->v.angles, state->groundangles );
+	}
+}
+
+/*
+=============
+SV_CheckSleeping
+
+returns true if entity may sleep for this frame,
+wakes it up otherwise
+=============
+*/
+static qboolean SV_CheckSleeping( edict_t *ent )
+{
+	sv_sleepstate_t	*state = &sv_sleep[NUM_FOR_EDICT( ent )];
+	float		thinktime, oldtime;
+
+	if( !state->sleeping )
+		return false;
+
+	thinktime = ent->v.nextthink;
+
+	// game dll or something else has changed the entity
+	if( !SV_IsResting( ent ))
+		goto wakeup;
+
+	if( ent->v.movetype == MOVETYPE_PUSH )
+	{
+		// the same checks as SV_Physics_Pusher does
+		oldtime = ent->v.ltime;
+
+		if( thinktime > oldtime && ( FBitSet( ent->v.flags, FL_ALWAYSTHINK ) || thinktime <= oldtime + sv.frametime ))
+			goto wakeup;
+
+		if( thinktime >= oldtime + sv.frametime )
+			ent->v.ltime += sv.frametime;
+		return true;
+	}
+
+	if( thinktime > 0.0f && thinktime <= ( sv.time + sv.frametime ))
+		goto wakeup;
+
+	if( ent->v.groundentity != state->ground )
+		goto wakeup;
+
+	if( !VectorCompare( state->ground->v.origin, state->groundorigin ) || !VectorCompare( state->ground->v.angles, state->groundangles ))
+		goto wakeup;
+
+	return true;
+wakeup:
+	state->sleeping = false;
+	return false;
+}
+
+/*
+===============================================================================
+
+PARALLEL MOVEMENT
+
+===============================================================================
+*/
+#define MAX_PHYSICS_THREADS	8
+#define MIN_PARALLEL_MOVES	16	// don't wake up threads for a few moves
+#define STEP_MOVE_REACH	32.0f	// step monsters walk in think functions without velocity
+
+// toss move which is queued until end of the frame,
+// the trace against world is done by worker threads
+typedef struct
+{
+	edict_t		*ent;		// NULL if already done
+	int		serialnumber;
+	vec3_t		lpush;
+	vec3_t		start;
+	vec3_t		end;
+	vec3_t		mins;
+	vec3_t		maxs;
+	vec3_t		boxmins;		// area swept by the move
+	vec3_t		boxmaxs;
+	trace_t		trace;		// against world only
+} sv_deferredmove_t;
+
+static struct
+{
+	qboolean		active;		// moves are deferred at this frame
+	qboolean		sleep;		// SV_Physics allows sleeping
+	sv_deferredmove_t	moves[MAX_EDICTS];
+	int		nummoves;
+	vec3_t		boxmins;		// encloses all queued moves
+	vec3_t		boxmaxs;
+	volatile long	nextmove;		// shared between threads
+
+	HANDLE		threads[MAX_PHYSICS_THREADS];
+	HANDLE		wakeup[MAX_PHYSICS_THREADS];
+	HANDLE		done[MAX_PHYSICS_THREADS];
+	int		numthreads;
+	int		wanted;		// sv_physthreads value threads was created for
+	qboolean		quit;
+} sv_parallel;
+
+/*
+=============
+SV_RunDeferredTraces
+
+trace queued moves against world, called by main
+and worker threads at the same time. World hulls are
+never changed during the frame so this is thread-safe
+=============
+*/
+static void SV_RunDeferredTraces( void )
+{
+	sv_deferredmove_t	*move;
+	long		i;
+
+	while(( i = InterlockedIncrement( &sv_parallel.nextmove ) - 1 ) < sv_parallel.nummoves )
+	{
+		move = &sv_parallel.moves[i];
+		if( !move->ent ) continue;
+
+		SV_ClipMoveToEntity( svgame.edicts, move->start, move->mins, move->maxs, move->end, &move->trace );
+	}
+}
+
+/*
+=============
+SV_PhysicsThread
+=============
+*/
+static DWORD WINAPI SV_PhysicsThread( void *arg )
+{
+	int	index = (int)(size_t)arg;
+
+	while( 1 )
+	{
+		WaitForSingleObject( sv_parallel.wakeup[index], INFINITE );
+		if( sv_parallel.quit ) break;
+
+		SV_RunDeferredTraces();
+		SetEvent( sv_parallel.done[index] );
+	}
+
+	return 0;
+}
+
+/*
+=============
+SV_StopPhysicsThreads
+=============
+*/
+void SV_StopPhysicsThreads( void )
+{
+	int	i;
+
+	sv_parallel.quit = true;
+
+	for( i = 0; i < sv_parallel.numthreads; i++ )
+		SetEvent( sv_parallel.wakeup[i] );
+
+	for( i = 0; i < sv_parallel.numthreads; i++ )
+	{
+		WaitForSingleObject( sv_parallel.threads[i], INFINITE );
+		CloseHandle( sv_parallel.threads[i] );
+		CloseHandle( sv_parallel.wakeup[i] );
+		CloseHandle( sv_parallel.done[i] );
+	}
+
+	sv_parallel.numthreads = 0;
+	sv_parallel.wanted = 0;
+	sv_parallel.quit = false;
+}
+
+/*
+=============
+SV_UpdatePhysicsThreads
+
+create worker threads as sv_physthreads says
+=============
+*/
+static void SV_UpdatePhysicsThreads( void )
+{
+	int	i, count;
+	DWORD	id;
+
+	count = bound( 0, (int)sv_physthreads.value, MAX_PHYSICS_THREADS );
+	if( count == sv_parallel.wanted )
+		return;
+
+	SV_StopPhysicsThreads();
+	sv_parallel.wanted = count;
+
+	// main thread is doing the traces too
+	for( i = 0; i < count - 1; i++ )
+	{
+		sv_parallel.wakeup[i] = CreateEvent( NULL, FALSE, FALSE, NULL );
+		sv_parallel.done[i] = CreateEvent( NULL, FALSE, FALSE, NULL );
+
+		if( sv_parallel.wakeup[i] && sv_parallel.done[i] )
+			sv_parallel.threads[i] = CreateThread( NULL, 0, SV_PhysicsThread, (void *)(size_t)i, 0, &id );
+		else sv_parallel.threads[i] = NULL;
+
+		if( !sv_parallel.threads[i] )
+		{
+			if( sv_parallel.wakeup[i] ) CloseHandle( sv_parallel.wakeup[i] );
+			if( sv_parallel.done[i] ) CloseHandle( sv_parallel.done[i] );
+			MsgDev( D_ERROR, "SV_UpdatePhysicsThreads: couldn't create thread, using %i\n", i + 1 );
+			break;
+		}
+
+		sv_parallel.numthreads++;
+	}
+}
+
+/*
+=============
+SV_CommitMove
+
+finish the queued move: clip it against entities,
+link entity and run touch functions
+=============
+*/
+static void SV_CommitMove( sv_deferredmove_t *move )
+{
+	edict_t	*ent = move->ent;
+	trace_t	trace;
+
+	move->ent = NULL;
+
+	if( ent->free || ent->serialnumber != move->serialnumber )
+		return;
+
+	// entity was teleported or pushed since the move was queued
+	if( !VectorCompare( ent->v.origin, move->start ) || !VectorCompare( ent->v.mins, move->mins ) || !VectorCompare( ent->v.maxs, move->maxs ))
+	{
+		VectorCopy( ent->v.origin, move->start );
+		VectorCopy( ent->v.mins, move->mins );
+		VectorCopy( ent->v.maxs, move->maxs );
+		VectorAdd( move->start, move->lpush, move->end );
+		SV_ClipMoveToEntity( svgame.edicts, move->start, move->mins, move->maxs, move->end, &move->trace );
+	}
+
+	trace = SV_MoveFromWorldTrace( &move->trace, ent->v.origin, ent->v.mins, ent->v.maxs, SV_PushMoveType( ent ), ent, FBitSet( ent->v.flags, FL_MONSTERCLIP ) ? true : false );
+	SV_FinishPush( ent, &trace, move->end, vec3_origin, NULL, 0.0f );
+	SV_FinishTossMove( ent, &trace );
+
+	// the same as SV_Physics does after SV_Physics_Entity
+	if( sv.state == ss_active && FBitSet( ent->v.flags, FL_KILLME ))
+		SV_FreeEdict( ent );
+	else if( sv_parallel.sleep && !ent->free )
+		SV_TryToSleep( ent );
+}
+
+/*
+=============
+SV_CommitMoveNow
+
+commit the queued move before its world trace is done
+=============
+*/
+static void SV_CommitMoveNow( sv_deferredmove_t *move )
+{
+	SV_ClipMoveToEntity( svgame.edicts, move->start, move->mins, move->maxs, move->end, &move->trace );
+	SV_CommitMove( move );
+}
+
+/*
+=============
+SV_CommitTouchedMoves
+
+commit queued moves which are in reach of the entity
+before it's simulated, so pushers, monsters and thinks
+see tossed entities at their new origin as in serial mode
+=============
+*/
+static void SV_CommitTouchedMoves( edict_t *ent )
+{
+	vec3_t	mins, maxs;
+	float	delta, reach = 1.0f;
+	int	i;
+
+	if( !sv_parallel.nummoves )
+		return;
+
+	if( ent->v.movetype == MOVETYPE_STEP || ent->v.movetype == MOVETYPE_PUSHSTEP )
+		reach = STEP_MOVE_REACH;
+
+	// area covered by the entity at this frame
+	for( i = 0; i < 3; i++ )
+	{
+		delta = ( ent->v.velocity[i] + ent->v.basevelocity[i] ) * sv.frametime;
+		mins[i] = ent->v.absmin[i] + Q_min( delta, 0.0f ) - reach;
+		maxs[i] = ent->v.absmax[i] + Q_max( delta, 0.0f ) + reach;
+	}
+
+	if( !BoundsIntersect( sv_parallel.boxmins, sv_parallel.boxmaxs, mins, maxs ))
+		return;
+
+	for( i = 0; i < sv_parallel.nummoves; i++ )
+	{
+		sv_deferredmove_t	*move = &sv_parallel.moves[i];
+
+		if( move->ent && move->ent != ent && BoundsIntersect( move->boxmins, move->boxmaxs, mins, maxs ))
+			SV_CommitMoveNow( move );
+	}
+}
+
+/*
+=============
+SV_DeferTossMove
+
+queue the move if it starts a new island: its swept area
+touches nothing but the world and other queued moves.
+Otherwise the island is committed right now to keep
+the order of moves and the move is done as usual
+=============
+*/
+qboolean SV_DeferTossMove( edict_t *ent, const vec3_t lpush )
+{
+	sv_deferredmove_t	*move, *check;
+	qboolean		joined = false;
+	int		i;
+
+	if( !sv_parallel.active || FBitSet( ent->v.flags, FL_KILLME ))
+		return false;
+
+	move = &sv_parallel.moves[sv_parallel.nummoves];
+	VectorCopy( lpush, move->lpush );
+	VectorCopy( ent->v.origin, move->start );
+	VectorAdd( ent->v.origin, lpush, move->end );
+	VectorCopy( ent->v.mins, move->mins );
+	VectorCopy( ent->v.maxs, move->maxs );
+	World_MoveBounds( move->start, move->mins, move->maxs, move->end, move->boxmins, move->boxmaxs );
+
+	if( ent->v.movetype == MOVETYPE_FLYMISSILE )
+	{
+		// missiles are clipped with enlarged monster boxes
+		for( i = 0; i < 3; i++ )
+		{
+			move->boxmins[i] -= 15.0f;
+			move->boxmaxs[i] += 15.0f;
+		}
+	}
+
+	for( i = 0; i < sv_parallel.nummoves; i++ )
+	{
+		check = &sv_parallel.moves[i];
+
+		if( !check->ent || !BoundsIntersect( check->boxmins, check->boxmaxs, move->boxmins, move->boxmaxs ))
+			continue;
+
+		SV_CommitMoveNow( check );
+		joined = true;
+	}
+
+	// touch functions may kill us
+	if( joined ) return ent->free;
+
+	if( SV_AreaHasSolids( sv_areanodes, move->boxmins, move->boxmaxs, ent ))
+		return false;
+
+	if( !sv_parallel.nummoves )
+		ClearBounds( sv_parallel.boxmins, sv_parallel.boxmaxs );
+	AddPointToBounds( move->boxmins, sv_parallel.boxmins, sv_parallel.boxmaxs );
+	AddPointToBounds( move->boxmaxs, sv_parallel.boxmins, sv_parallel.boxmaxs );
+
+	move->ent = ent;
+	move->serialnumber = ent->serialnumber;
+	sv_parallel.nummoves++;
+
+	return true;
+}
+
+/*
+=============
+SV_RunDeferredMoves
+
+trace all queued moves in parallel and commit
+the rest of them. Nothing simulated after the move
+was queued has been in reach of it, so the order
+doesn't matter
+=============
+*/
+static void SV_RunDeferredMoves( void )
+{
+	int	i, numthreads = 0;
+
+	if( !sv_parallel.nummoves )
+		return;
+
+	SV_BeginPhase( SVP_PARALLEL );
+	sv_parallel.nextmove = 0;
+
+	if( sv_parallel.nummoves >= MIN_PARALLEL_MOVES )
+		numthreads = sv_parallel.numthreads;
+
+	for( i = 0; i < numthreads; i++ )
+		SetEvent( sv_parallel.wakeup[i] );
+
+	SV_RunDeferredTraces();
+
+	if( numthreads > 0 )
+		WaitForMultipleObjects( numthreads, sv_parallel.done, TRUE, INFINITE );
+	SV_EndPhase( SVP_PARALLEL );
+
+	for( i = 0; i < sv_parallel.nummoves; i++ )
+	{
+		if( !sv_parallel.moves[i].ent )
+			continue;
+
+		sv.physics_parallel++;
+		SV_CommitMove( &sv_parallel.moves[i] );
+	}
+
+	sv_parallel.nummoves = 0;
+}
+
+/*
+=============
+SV_IsIdleEntity
+
+static entity which is not going to think at this frame,
+SV_Physics_Entity will do nothing with it.
+NOTE: this only makes the per-edict visit cheap, SV_Physics
+still walks all edicts each frame. A think queue keyed on
+nextthink can't be kept here because game dll writes
+pev->nextthink directly and engine is never told about it
+=============
+*/
+static qboolean SV_IsIdleEntity( edict_t *ent )
+{
+	float	thinktime;
+
+	if( ent->v.movetype != MOVETYPE_NONE )
+		return false;
+
+	if( FBitSet( ent->v.flags, FL_KILLME|FL_ONGROUND|FL_BASEVELOCITY ))
+		return false;
+
+	// the same check as SV_RunThink does
+	thinktime = ent->v.nextthink;
+	if( thinktime > 0.0f && thinktime <= ( sv.time + sv.frametime ))
+		return false;
+
+	return VectorIsNull( ent->v.basevelocity );
+}
+
 //============================================================================
 static void SV_Physics_Entity( edict_t *ent )
 {
@@ -1780,15 +2379,30 @@ SV_Physics
 */
 void SV_Physics( void )
 {
+	qboolean	skipidle, sleep;
 	edict_t	*ent;
 	int    	i;
 	
+	SV_BeginPhase( SVP_PHYSICS );
 	SV_CheckAllEnts ();
 
 	svgame.globals->time = sv.time;
 
 	// let the progs know that a new frame has started
+	SV_BeginPhase( SVP_STARTFRAME );
 	svgame.dllFuncs.pfnStartFrame();
+	SV_EndPhase( SVP_STARTFRAME );
+
+	// custom physics and retouch should see each entity
+	skipidle = ( sv_skipidle.value && !svgame.physFuncs.SV_PhysicsEntity && svgame.globals->force_retouch == 0.0f );
+	sleep = ( skipidle && sv_sleepents.value );
+	sv.physics_active = sv.physics_idle = sv.physics_sleeping = 0;
+	sv.physics_parallel = 0;
+
+	// worker threads can't call the game dll
+	SV_UpdatePhysicsThreads();
+	sv_parallel.active = ( sv_physthreads.value > 0.0f && !svgame.physFuncs.SV_PhysicsEntity && !svgame.physFuncs.SV_HullForBsp );
+	sv_parallel.sleep = sleep;
 
 	// treat each object in turn
 	for( i = 0; i < svgame.numEntities; i++ )
@@ -1801,9 +2415,33 @@ void SV_Physics( void )
 		if( i > 0 && i <= svgame.globals->maxClients )
                    		continue;
 
+		if( skipidle && SV_IsIdleEntity( ent ))
+		{
+			sv.physics_idle++;
+			continue;
+		}
+
+		if( sleep && SV_CheckSleeping( ent ))
+		{
+			sv.physics_sleeping++;
+			continue;
+		}
+
+		sv.physics_active++;
+		SV_CommitTouchedMoves( ent );
+
+		// touch functions may remove it
+		if( ent->free ) continue;
+
 		SV_Physics_Entity( ent );
+
+		if( sleep && !ent->free )
+			SV_TryToSleep( ent );
 	}
 
+	SV_RunDeferredMoves();
+	sv_parallel.active = false;
+
 	if( svgame.globals->force_retouch != 0.0f )
 		svgame.globals->force_retouch--;
 
@@ -1822,6 +2460,7 @@ void SV_Physics( void )
 
 	// decrement svgame.numEntities if the highest number entities died
 	for( ; EDICT_NUM( svgame.numEntities - 1 )->free; svgame.numEntities-- );
+	SV_EndPhase( SVP_PHYSICS );
 }
 
 /*
@@ -2042,6 +2681,7 @@ static server_physics_api_t gPhysicsAPI =
 	COM_SaveFile,
 	pfnLoadImagePixels,
 	pfnGetModelName,
+	SV_AreaEdicts,
 };
 
 /*
@@ -2058,9 +2698,19 @@ qboolean SV_InitPhysicsAPI( void )
 	pPhysIface = (PHYSICAPI)Com_GetProcAddress( svgame.hInstance, "Server_GetPhysicsInterface" );
 	if( pPhysIface )
 	{
-		if( pPhysIface( SV_PHYSICS_INTERFACE_VERSION, &gPhysicsAPI, &svgame.physFuncs ))
+		int	version = SV_PHYSICS_INTERFACE_VERSION;
+
+		// mods built with previous version accept only their own number,
+		// table of version 6 is a prefix of the current one
+		if( !pPhysIface( version, &gPhysicsAPI, &svgame.physFuncs ))
+		{
+			memset( &svgame.physFuncs, 0, sizeof( svgame.physFuncs ));
+			version = SV_PHYSICS_INTERFACE_VERSION_6;
+		}
+
+		if( version == SV_PHYSICS_INTERFACE_VERSION || pPhysIface( version, &gPhysicsAPI, &svgame.physFuncs ))
 		{
-			MsgDev( D_REPORT, "SV_LoadProgs: ^2initailized extended PhysicAPI ^7ver. %i\n", SV_PHYSICS_INTERFACE_VERSION );
+			MsgDev( D_REPORT, "SV_LoadProgs: ^2initailized extended PhysicAPI ^7ver. %i\n", version );
 
 			if( svgame.physFuncs.SV_CheckFeatures != NULL )
 			{
@@ -761,42 +761,242 @@ static void SV_FinishPMove( playermove_t *pmove, sv_client_t *cl )
 	pmove->runfuncs = false;
 }
 
-entity_state_t *SV_FindEntInPack( int index, client_frame_t *frame )
+qboolean SV_UnlagCheckTeleport( vec3_t old_pos, vec3_t new_pos )
 {
-	entity_state_t	*state;
-	int		i;	
+	int	i;
 
-	for( i = 0; i < frame->num_entities; i++ )
+	for( i = 0; i < 3; i++ )
 	{
-		state = &svs.packet_entities[(frame->first_entity+i)%svs.num_client_entities];
-
-		if( state->number == index )
-			return state;
+		if( fabs( old_pos[i] - new_pos[i] ) > 64.0f )
+			return true;
 	}
-	return NULL;
+	return false;
 }
 
-qboolean SV_UnlagCheckTeleport( vec3_t old_pos, vec3_t new_pos )
+/*
+=============================================================================
+
+	LAG COMPENSATION HISTORY
+
+	positions of players and entities marked with FL_LAGCOMPENSATE
+	are recorded once per server frame, so rewind doesn't need
+	to search through the packet entities of each client frame
+
+=============================================================================
+*/
+#define UNLAG_HISTORY		256		// server frames, must be power of two
+#define UNLAG_MASK			(UNLAG_HISTORY - 1)
+#define MAX_UNLAG_SLOTS		(MAX_CLIENTS + MAX_UNLAG_ENTS)
+
+typedef struct
+{
+	double		time;		// host.realtime when frame was sent
+	vec3_t		origin;
+	vec3_t		mins;
+	vec3_t		maxs;
+	int		sequence;		// changes after teleport, death etc
+	qboolean		nointerp;
+} sv_unlagsample_t;
+
+typedef struct
+{
+	int		entnum;		// 0 is free slot
+	int		serialnumber;	// to detect reused edicts
+	int		head;		// next sample to write
+	int		count;		// valid samples
+	int		sequence;
+	sv_unlagsample_t	samples[UNLAG_HISTORY];
+} sv_unlaghistory_t;
+
+// first MAX_CLIENTS slots are reserved for players
+static sv_unlaghistory_t	sv_unlag_history[MAX_UNLAG_SLOTS];
+static byte		sv_unlag_tracked[MAX_EDICTS_BYTES];
+
+/*
+=============
+SV_ClearUnlagHistory
+=============
+*/
+void SV_ClearUnlagHistory( void )
 {
 	int	i;
 
-	for( i = 0; i < 3; i++ )
+	for( i = 0; i < MAX_UNLAG_SLOTS; i++ )
 	{
-		if( fabs( old_pos[i] - new_pos[i] ) > 64.0f )
-			return true;
+		sv_unlag_history[i].entnum = 0;
+		sv_unlag_history[i].count = 0;
 	}
-	return false;
+
+	memset( sv_unlag_tracked, 0, sizeof( sv_unlag_tracked ));
+}
+
+/*
+=============
+SV_RecordUnlagSample
+=============
+*/
+static void SV_RecordUnlagSample( sv_unlaghistory_t *hist, edict_t *ent )
+{
+	sv_unlagsample_t	*sample, *prev;
+
+	if( hist->entnum != NUM_FOR_EDICT( ent ) || hist->serialnumber != ent->serialnumber )
+	{
+		// slot is taken by another entity
+		hist->entnum = NUM_FOR_EDICT( ent );
+		hist->serialnumber = ent->serialnumber;
+		hist->count = 0;
+	}
+
+	sample = &hist->samples[hist->head];
+	sample->time = host.realtime;
+	sample->nointerp = FBitSet( ent->v.effects, EF_NOINTERP ) ? true : false;
+
+	// dead players and monsters are not rewound, brush movers have no health
+	if( FBitSet( ent->v.flags, FL_CLIENT|FL_MONSTER ) && ent->v.health <= 0 )
+		sample->nointerp = true;
+	VectorCopy( ent->v.origin, sample->origin );
+	VectorCopy( ent->v.mins, sample->mins );
+	VectorCopy( ent->v.maxs, sample->maxs );
+
+	if( hist->count > 0 )
+	{
+		prev = &hist->samples[(hist->head - 1) & UNLAG_MASK];
+
+		// can't interpolate across this sample
+		if( sample->nointerp || SV_UnlagCheckTeleport( prev->origin, sample->origin ))
+			hist->sequence++;
+	}
+
+	sample->sequence = hist->sequence;
+	hist->head = (hist->head + 1) & UNLAG_MASK;
+	hist->count = Q_min( hist->count + 1, UNLAG_HISTORY );
+}
+
+/*
+=============
+SV_RecordUnlagHistory
+
+called once per server frame before
+sending messages to clients
+=============
+*/
+void SV_RecordUnlagHistory( void )
+{
+	sv_unlaghistory_t	*hist;
+	sv_client_t	*cl;
+	edict_t		*ent;
+	int		i;
+
+	// don't allow unlag in singleplayer
+	if( svs.maxclients <= 1 || !sv_unlag.value )
+		return;
+
+	if( !svgame.dllFuncs.pfnAllowLagCompensation( ))
+		return;
+
+	for( i = 0, cl = svs.clients; i < svs.maxclients; i++, cl++ )
+	{
+		if( cl->state != cs_spawned )
+		{
+			sv_unlag_history[i].count = 0;
+			continue;
+		}
+
+		SV_RecordUnlagSample( &sv_unlag_history[i], cl->edict );
+	}
+
+	// release slots of removed entities
+	for( i = MAX_CLIENTS; i < MAX_UNLAG_SLOTS; i++ )
+	{
+		hist = &sv_unlag_history[i];
+		if( !hist->entnum ) continue;
+
+		ent = EDICT_NUM( hist->entnum );
+
+		if( !SV_IsValidEdict( ent ) || ent->serialnumber != hist->serialnumber || !FBitSet( ent->v.flags, FL_LAGCOMPENSATE ))
+		{
+			ClearBits( sv_unlag_tracked[hist->entnum>>3], BIT( hist->entnum & 7 ));
+			hist->entnum = 0;
+			hist->count = 0;
+			continue;
+		}
+
+		SV_RecordUnlagSample( hist, ent );
+	}
+
+	// monsters and brush entities is tracked by game request
+	for( i = svs.maxclients + 1; i < svgame.numEntities; i++ )
+	{
+		ent = EDICT_NUM( i );
+
+		if( !SV_IsValidEdict( ent ) || !FBitSet( ent->v.flags, FL_LAGCOMPENSATE ))
+			continue;
+
+		if( FBitSet( sv_unlag_tracked[i>>3], BIT( i & 7 )))
+			continue; // already recorded
+
+		for( hist = &sv_unlag_history[MAX_CLIENTS]; hist < &sv_unlag_history[MAX_UNLAG_SLOTS]; hist++ )
+		{
+			if( !hist->entnum ) break;
+		}
+
+		if( hist == &sv_unlag_history[MAX_UNLAG_SLOTS] )
+			break; // no free slots
+
+		SetBits( sv_unlag_tracked[i>>3], BIT( i & 7 ));
+		SV_RecordUnlagSample( hist, ent );
+	}
+}
+
+/*
+=============
+SV_FindUnlagSample
+
+find the latest sample that is not newer than time
+=============
+*/
+static int SV_FindUnlagSample( sv_unlaghistory_t *hist, double time )
+{
+	int	first = hist->head - hist->count;
+	int	lo = 0, hi = hist->count - 1, mid;
+	int	found = -1;
+
+	while( lo <= hi )
+	{
+		mid = ( lo + hi ) >> 1;
+
+		if( hist->samples[(first + mid) & UNLAG_MASK].time <= time )
+		{
+			found = mid;
+			lo = mid + 1;
+		}
+		else hi = mid - 1;
+	}
+
+	return found;
+}
+
+/*
+=============
+SV_UnlagEdict
+=============
+*/
+static edict_t *SV_UnlagEdict( int slot )
+{
+	if( slot < MAX_CLIENTS )
+		return svs.clients[slot].edict;
+	return EDICT_NUM( sv_unlag_history[slot].entnum );
 }
 
 void SV_SetupMoveInterpolant( sv_client_t *cl )
 {
-	int		i, j, clientnum;
+	int		i, k, first;
 	float		finalpush, lerp_msec;
 	float		latency, lerpFrac;
-	client_frame_t	*frame, *frame2;
-	entity_state_t	*state, *lerpstate;
-	vec3_t		curpos, newpos;
-	sv_client_t	*check;
+	sv_unlagsample_t	*from, *to, *last;
+	sv_unlaghistory_t	*hist;
+	vec3_t		curpos, mins, maxs;
+	edict_t		*check;
 	sv_interp_t	*lerp;
 
 	memset( svgame.interp, 0, sizeof( svgame.interp ));
@@ -816,19 +1016,6 @@ void SV_SetupMoveInterpolant( sv_client_t *cl )
 
 	has_update = true;
 
-	for( i = 0, check = svs.clients; i < svs.maxclients; i++, check++ )
-	{
-		if( check->state != cs_spawned || check == cl )
-			continue;
-
-		lerp = &svgame.interp[i];
-
-		VectorCopy( check->edict->v.origin, lerp->oldpos );
-		VectorCopy( check->edict->v.absmin, lerp->mins );
-		VectorCopy( check->edict->v.absmax, lerp->maxs );
-		lerp->active = true;
-	}
-
 	if( cl->latency > 1.5f )
 		latency = 1.5f;
 	else latency = cl->latency;
@@ -851,99 +1038,74 @@ void SV_SetupMoveInterpolant( sv_client_t *cl )
 	finalpush = ( host.realtime - latency - lerp_msec ) + sv_unlagpush.value;
 	if( finalpush > host.realtime ) finalpush = host.realtime; // pushed too much ?
 
-	frame = NULL;
-
-	for( frame2 = NULL, i = 0; i < SV_UPDATE_BACKUP; i++, frame2 = frame )
+	for( i = 0, hist = sv_unlag_history; i < MAX_UNLAG_SLOTS; i++, hist++ )
 	{
-		frame = &cl->frames[(cl->netchan.outgoing_sequence - 1) & SV_UPDATE_MASK];
+		if( i >= svs.maxclients && i < MAX_CLIENTS )
+			continue; // unused player slots
 
-		for( j = 0; j < frame->num_entities; j++ )
-		{
-			state = &svs.packet_entities[(frame->first_entity+j)%svs.num_client_entities];
+		if( !hist->count || ( i < MAX_CLIENTS && ( &svs.clients[i] == cl || svs.clients[i].state != cs_spawned )))
+			continue;
 
-			if( state->number <= 0 || state->number >= svs.maxclients )
-				continue;
+		check = SV_UnlagEdict( i );
 
-			lerp = &svgame.interp[state->number-1];
-			if( lerp->nointerp ) continue;
+		if( !SV_IsValidEdict( check ) || check->serialnumber != hist->serialnumber )
+			continue;
+		lerp = &svgame.interp[i];
+		lerp->serialnumber = check->serialnumber;
 
-			if( state->health <= 0 || ( state->effects & EF_NOINTERP ))
-				lerp->nointerp = true;
+		VectorCopy( check->v.origin, lerp->oldpos );
+		VectorCopy( check->v.absmin, lerp->mins );
+		VectorCopy( check->v.absmax, lerp->maxs );
+		lerp->active = true;
 
-			if( !lerp->firstframe )
-				lerp->firstframe = true;
-			else if( SV_UnlagCheckTeleport( state->origin, lerp->finalpos ))
-				lerp->nointerp = true;
+		k = SV_FindUnlagSample( hist, finalpush );
+		if( k == -1 ) continue; // too old
 
-			VectorCopy( state->origin, lerp->finalpos );
-		}
+		first = hist->head - hist->count;
+		from = &hist->samples[(first + k) & UNLAG_MASK];
+		to = ( k + 1 < hist->count ) ? &hist->samples[(first + k + 1) & UNLAG_MASK] : from;
+		last = &hist->samples[(hist->head - 1) & UNLAG_MASK];
 
-		if( finalpush > frame->senttime )
-			break;
-	}
+		if( finalpush - from->time > 1.0 )
+			continue;
 
-	if( i == SV_UPDATE_BACKUP || finalpush - frame->senttime > 1.0 )
-	{
-		memset( svgame.interp, 0, sizeof( svgame.interp ));
-		has_update = false;
-		return;
-	}
+		// entity was teleported or killed since then
+		if( from->sequence != last->sequence || from->nointerp || to->nointerp )
+		{
+			lerp->nointerp = true;
+			continue;
+		}
 
-	if( !frame2 )
-	{
-		frame2 = frame;
-		lerpFrac = 0;
-	}
-	else
-	{
-		if( frame2->senttime - frame->senttime == 0.0 )
+		if( to->time - from->time == 0.0 )
 		{
 			lerpFrac = 0;
 		}
 		else
 		{
-			lerpFrac = (finalpush - frame->senttime) / (frame2->senttime - frame->senttime);
+			lerpFrac = (finalpush - from->time) / (to->time - from->time);
 			lerpFrac = bound( 0.0f, lerpFrac, 1.0f );
 		}
-	}
 
-	for( i = 0; i < frame->num_entities; i++ )
-	{
-		state = &svs.packet_entities[(frame->first_entity+i)%svs.num_client_entities];
-
-		if( state->number <= 0 || state->number >= svs.maxclients )
-			continue;
-
-		clientnum = state->number - 1;
-		check = &svs.clients[clientnum];
-
-		if( check->state != cs_spawned || check == cl )
-			continue;
-
-		lerp = &svgame.interp[clientnum];
-
-		if( !lerp->active || lerp->nointerp )
-			continue;
+		VectorLerp( from->origin, lerpFrac, to->origin, curpos );
+		VectorCopy( from->mins, mins );
+		VectorCopy( from->maxs, maxs );
 
-		lerpstate = SV_FindEntInPack( state->number, frame2 );
+		VectorCopy( curpos, lerp->curpos );
+		VectorCopy( curpos, lerp->newpos );
 
-		if( !lerpstate )
-		{
-			VectorCopy( state->origin, curpos );
-		}
-		else
+		// ducked player has another hull
+		if( !VectorCompare( mins, check->v.mins ) || !VectorCompare( maxs, check->v.maxs ))
 		{
-			VectorSubtract( lerpstate->origin, state->origin, newpos );
-			VectorMA( state->origin, lerpFrac, newpos, curpos );
+			VectorCopy( check->v.mins, lerp->oldmins );
+			VectorCopy( check->v.maxs, lerp->oldmaxs );
+			SV_SetMinMaxSize( check, mins, maxs, false );
+			lerp->resized = true;
 		}
 
-		VectorCopy( curpos, lerp->curpos );
-		VectorCopy( curpos, lerp->newpos );
-
-		if( !VectorCompare( curpos, check->edict->v.origin ))
+		if( !VectorCompare( curpos, check->v.origin ) || lerp->resized )
 		{
-			VectorCopy( curpos, check->edict->v.origin );
-			SV_LinkEdict( check->edict, false );
+			VectorCopy( curpos, check->v.origin );
+			SV_LinkEdict( check, false );
 			lerp->moving = true;
 		}
 	}
@@ -951,8 +1113,8 @@ void SV_SetupMoveInterpolant( sv_client_t *cl )
 
 void SV_RestoreMoveInterpolant( sv_client_t *cl )
 {
-	sv_client_t	*check;
 	sv_interp_t	*oldlerp;
+	edict_t		*check;
 	int		i;
 
 	if( !has_update )
@@ -973,24 +1135,29 @@ void SV_RestoreMoveInterpolant( sv_client_t *cl )
 	if( !FBitSet( cl->flags, FCL_LAG_COMPENSATION ))
 		return;
 
-	for( i = 0, check = svs.clients; i < svs.maxclients; i++, check++ )
+	for( i = 0; i < MAX_UNLAG_SLOTS; i++ )
 	{
-		if( check->state != cs_spawned || check == cl )
+		oldlerp = &svgame.interp[i];
+
+		if( !oldlerp->moving || !oldlerp->active )
 			continue;
 
-		oldlerp = &svgame.interp[i];
+		check = SV_UnlagEdict( i );
+
+		// edict was freed and reused while running the usercmd
+		if( !SV_IsValidEdict( check ) || check->serialnumber != oldlerp->serialnumber )
+			continue;
+
+		if( oldlerp->resized )
+			SV_SetMinMaxSize( check, oldlerp->oldmins, oldlerp->oldmaxs, false );
 
-		if( VectorCompare( oldlerp->oldpos, oldlerp->newpos ))
+		if( VectorCompare( oldlerp->oldpos, oldlerp->newpos ) && !oldlerp->resized )
 			continue; // they didn't actually move.
 
-		if( !oldlerp->moving || !oldlerp->active )
-			return;
+		if( VectorCompare( oldlerp->curpos, check->v.origin ))
+			VectorCopy( oldlerp->oldpos, check->v.origin );
 
-		if( VectorCompare( oldlerp->curpos, check->edict->v.origin ))
-		{
-			VectorCopy( oldlerp->oldpos, check->edict->v.origin );
-			SV_LinkEdict( check->edict, false );
-		}
+		SV_LinkEdict( check, false );
 	}
 }
 
@@ -1062,7 +1229,9 @@ void SV_RunCmd( sv_client_t *cl, usercmd_t *ucmd, int random_seed )
 	}
 
 	svgame.globals->time = cl->timebase;
+	SV_BeginPhase( SVP_PLAYERPRETHINK );
 	svgame.dllFuncs.pfnPlayerPreThink( clent );
+	SV_EndPhase( SVP_PLAYERPRETHINK );
 	SV_PlayerRunThink( clent, frametime, cl->timebase );
 
 	// If conveyor, or think, set basevelocity, then send to client asap too.
@@ -1073,7 +1242,9 @@ void SV_RunCmd( sv_client_t *cl, usercmd_t *ucmd, int random_seed )
 	SV_SetupPMove( svgame.pmove, cl, ucmd, cl->physinfo );
 
 	// motor!
+	SV_BeginPhase( SVP_PLAYERMOVE );
 	svgame.dllFuncs.pfnPM_Move( svgame.pmove, true );
+	SV_EndPhase( SVP_PLAYERMOVE );
 
 	// copy results back to client
 	SV_FinishPMove( svgame.pmove, cl );
@@ -1111,7 +1282,9 @@ void SV_RunCmd( sv_client_t *cl, usercmd_t *ucmd, int random_seed )
 	svgame.globals->frametime = frametime;
 
 	// run post-think
+	SV_BeginPhase( SVP_PLAYERPOSTTHINK );
 	svgame.dllFuncs.pfnPlayerPostThink( clent );
+	SV_EndPhase( SVP_PLAYERPOSTTHINK );
 	svgame.dllFuncs.pfnCmdEnd( clent );
 
 	if( !FBitSet( cl->flags, FCL_FAKECLIENT ))
@@ -0,0 +1,375 @@
+/*
+sv_profile.c - server frame phases profiler
+Copyright (C) 2017 Uncle Mike
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+*/
+
+#include "common.h"
+#include "server.h"
+
+#define PROFILE_FRAMES	512			// rolling window size, must be power of two
+#define PROFILE_MASK	(PROFILE_FRAMES - 1)
+
+#define TRACE_IDENT		(('T'<<24)+('P'<<16)+('V'<<8)+'S')	// little-endian "SVPT"
+#define TRACE_VERSION	1
+
+typedef struct
+{
+	const char	*name;
+	int		parent;		// used only for printing the tree
+} sv_phaseinfo_t;
+
+// NOTE: keep in order with sv_phase_t
+static const sv_phaseinfo_t sv_phases[SVP_COUNT] =
+{
+{ "frame",		-1 },
+{ "readpackets",		SVP_FRAME },
+{ "ClientCommand",		SVP_READPACKETS },
+{ "PlayerPreThink",		SVP_READPACKETS },
+{ "PM_Move",		SVP_READPACKETS },
+{ "PlayerPostThink",	SVP_READPACKETS },
+{ "timeouts",		SVP_FRAME },
+{ "gameframe",		SVP_FRAME },
+{ "physics",		SVP_GAMEFRAME },
+{ "StartFrame",		SVP_PHYSICS },
+{ "Think",		SVP_PHYSICS },
+{ "Touch",		SVP_PHYSICS },
+{ "Blocked",		SVP_PHYSICS },
+{ "parallel",		SVP_PHYSICS },
+{ "sendmessages",		SVP_FRAME },
+{ "SetupVisibility",	SVP_SENDMESSAGES },
+{ "AddToFullPack",		SVP_SENDMESSAGES },
+{ "UpdateClientData",	SVP_SENDMESSAGES },
+{ "prepworld",		SVP_FRAME },
+{ "heartbeat",		SVP_FRAME },
+};
+
+// header of binary trace file, followed by SVP_COUNT phase descriptions
+// and sv_traceframe_t for each server frame
+typedef struct
+{
+	int		ident;
+	int		version;
+	int		numphases;
+	int		framesize;		// sizeof( sv_traceframe_t )
+} sv_traceheader_t;
+
+typedef struct
+{
+	char		name[32];
+	int		parent;
+} sv_tracephase_t;
+
+typedef struct
+{
+	int		framecount;		// host.framecount
+	float		time;			// sv.time
+	float		msec[SVP_COUNT];		// inclusive time of each phase
+	int		calls[SVP_COUNT];		// how many times phase was entered
+} sv_traceframe_t;
+
+typedef struct
+{
+	double		start;			// when outer call was started
+	double		total;			// accumulated for current frame
+	int		depth;			// phases like Touch can be nested
+	int		calls;
+
+	float		samples[PROFILE_FRAMES];	// msec
+	int		numcalls[PROFILE_FRAMES];
+} sv_phasestats_t;
+
+static struct
+{
+	sv_phasestats_t	phases[SVP_COUNT];
+	int		numframes;		// total frames recorded
+	file_t		*trace;
+	int		tracedframes;
+} sv_prof;
+
+CVAR_DEFINE_AUTO( sv_profile, "0", 0, "measure time of server frame phases and game DLL callbacks, see sv_profile_dump" );
+
+/*
+================
+SV_ProfileBegin
+================
+*/
+void SV_ProfileBegin( sv_phase_t phase )
+{
+	sv_phasestats_t	*p = &sv_prof.phases[phase];
+
+	p->calls++;
+
+	// recursive call is already measured by outer one
+	if( p->depth++ == 0 )
+		p->start = Sys_DoubleTime();
+}
+
+/*
+================
+SV_ProfileEnd
+================
+*/
+void SV_ProfileEnd( sv_phase_t phase )
+{
+	sv_phasestats_t	*p = &sv_prof.phases[phase];
+
+	if( p->depth <= 0 )
+		return; // profiler was enabled in the middle of phase
+
+	if( --p->depth == 0 )
+		p->total += Sys_DoubleTime() - p->start;
+}
+
+/*
+================
+SV_ProfileFrameBegin
+
+latch sv_profile so begin\end pairs are always matched
+================
+*/
+void SV_ProfileFrameBegin( void )
+{
+	sv_phasestats_t	*p;
+	int		i;
+
+	svs.profiling = ( sv_profile.value != 0.0f || sv_prof.trace != NULL );
+	if( !svs.profiling ) return;
+
+	for( i = 0, p = sv_prof.phases; i < SVP_COUNT; i++, p++ )
+	{
+		p->total = 0.0;
+		p->depth = 0;
+		p->calls = 0;
+	}
+
+	SV_ProfileBegin( SVP_FRAME );
+}
+
+/*
+================
+SV_ProfileFrameEnd
+
+store frame results into rolling window
+and trace file
+================
+*/
+void SV_ProfileFrameEnd( void )
+{
+	sv_traceframe_t	frame;
+	sv_phasestats_t	*p;
+	int		i, slot;
+
+	if( !svs.profiling ) return;
+
+	SV_ProfileEnd( SVP_FRAME );
+	slot = sv_prof.numframes & PROFILE_MASK;
+
+	for( i = 0, p = sv_prof.phases; i < SVP_COUNT; i++, p++ )
+	{
+		p->samples[slot] = p->total * 1000.0;
+		p->numcalls[slot] = p->calls;
+		frame.msec[i] = p->samples[slot];
+		frame.calls[i] = p->calls;
+	}
+
+	sv_prof.numframes++;
+
+	if( sv_prof.trace )
+	{
+		frame.framecount = host.framecount;
+		frame.time = sv.time;
+		FS_Write( sv_prof.trace, &frame, sizeof( frame ));
+		sv_prof.tracedframes++;
+	}
+
+	svs.profiling = false;
+}
+
+/*
+================
+SV_CompareSamples
+================
+*/
+static int SV_CompareSamples( const void *a, const void *b )
+{
+	float	fa = *(const float *)a;
+	float	fb = *(const float *)b;
+
+	if( fa < fb ) return -1;
+	if( fa > fb ) return 1;
+	return 0;
+}
+
+/*
+================
+SV_PrintPhase
+
+print phase and all of its children
+================
+*/
+static void SV_PrintPhase( int phase, int level, int numframes )
+{
+	sv_phasestats_t	*p = &sv_prof.phases[phase];
+	float		sorted[PROFILE_FRAMES];
+	float		sum = 0.0f;
+	int		i, calls = 0;
+	char		name[64];
+
+	for( i = 0; i < numframes; i++ )
+	{
+		sorted[i] = p->samples[i];
+		calls += p->numcalls[i];
+		sum += sorted[i];
+	}
+
+	qsort( sorted, numframes, sizeof( float ), SV_CompareSamples );
+
+	// indent child phases
+	Q_snprintf( name, sizeof( name ), "%*s%s", level * 2, "", sv_phases[phase].name );
+
+	Msg( "%-24s %8.3f %8.3f %8.3f %8.3f %8.1f\n", name, sorted[0], sum / numframes,
+		sorted[(numframes - 1) * 99 / 100], sorted[numframes - 1], (float)calls / numframes );
+
+	for( i = 0; i < SVP_COUNT; i++ )
+	{
+		if( sv_phases[i].parent == phase )
+			SV_PrintPhase( i, level + 1, numframes );
+	}
+}
+
+/*
+================
+SV_ProfileDump_f
+================
+*/
+static void SV_ProfileDump_f( void )
+{
+	int	numframes = Q_min( sv_prof.numframes, PROFILE_FRAMES );
+
+	if( !numframes )
+	{
+		Msg( "no profile data, set sv_profile to 1 and run the server\n" );
+		return;
+	}
+
+	Msg( "server frame phases over last %i frames (msec)\n", numframes );
+	Msg( "%-24s %8s %8s %8s %8s %8s\n", "phase", "min", "avg", "p99", "max", "calls" );
+	Msg( "-------------------------------------------------------------------------\n" );
+	SV_PrintPhase( SVP_FRAME, 0, numframes );
+
+	if( sv_prof.trace )
+		Msg( "tracing, %i frames written\n", sv_prof.tracedframes );
+}
+
+/*
+================
+SV_ProfileReset_f
+================
+*/
+static void SV_ProfileReset_f( void )
+{
+	memset( sv_prof.phases, 0, sizeof( sv_prof.phases ));
+	sv_prof.numframes = 0;
+}
+
+/*
+================
+SV_StopTrace
+================
+*/
+static void SV_StopTrace( void )
+{
+	if( !sv_prof.trace ) return;
+
+	FS_Close( sv_prof.trace );
+	Msg( "profile trace stopped, %i frames written\n", sv_prof.tracedframes );
+	sv_prof.trace = NULL;
+}
+
+/*
+================
+SV_ProfileTrace_f
+
+write each server frame timings into binary file
+================
+*/
+static void SV_ProfileTrace_f( void )
+{
+	sv_traceheader_t	header;
+	sv_tracephase_t	info;
+	string		filename;
+	int		i;
+
+	if( Cmd_Argc() != 2 )
+	{
+		Msg( "Usage: sv_profile_trace <filename> or sv_profile_trace stop\n" );
+		return;
+	}
+
+	SV_StopTrace();
+
+	if( !Q_stricmp( Cmd_Argv( 1 ), "stop" ))
+		return;
+
+	Q_strncpy( filename, Cmd_Argv( 1 ), sizeof( filename ));
+	FS_DefaultExtension( filename, ".svp" );
+
+	sv_prof.trace = FS_Open( filename, "wb", true );
+
+	if( !sv_prof.trace )
+	{
+		MsgDev( D_ERROR, "SV_ProfileTrace: couldn't create %s\n", filename );
+		return;
+	}
+
+	header.ident = TRACE_IDENT;
+	header.version = TRACE_VERSION;
+	header.numphases = SVP_COUNT;
+	header.framesize = sizeof( sv_traceframe_t );
+	FS_Write( sv_prof.trace, &header, sizeof( header ));
+
+	for( i = 0; i < SVP_COUNT; i++ )
+	{
+		memset( &info, 0, sizeof( info ));
+		Q_strncpy( info.name, sv_phases[i].name, sizeof( info.name ));
+		info.parent = sv_phases[i].parent;
+		FS_Write( sv_prof.trace, &info, sizeof( info ));
+	}
+
+	sv_prof.tracedframes = 0;
+	Msg( "tracing server frames into %s\n", filename );
+}
+
+/*
+================
+SV_InitProfiler
+================
+*/
+void SV_InitProfiler( void )
+{
+	Cvar_RegisterVariable( &sv_profile );
+	Cmd_AddCommand( "sv_profile_dump", SV_ProfileDump_f, "print min/avg/p99/max time of server frame phases" );
+	Cmd_AddCommand( "sv_profile_reset", SV_ProfileReset_f, "clear collected server frame profile" );
+	Cmd_AddCommand( "sv_profile_trace", SV_ProfileTrace_f, "write per-frame phase timings into binary file" );
+}
+
+/*
+================
+SV_ShutdownProfiler
+================
+*/
+void SV_ShutdownProfiler( void )
+{
+	SV_StopTrace();
+	svs.profiling = false;
+}
@@ -31,10 +31,16 @@ half-life implementation of saverestore system
 #define SAVEGAME_HEADER		(('V'<<24)+('A'<<16)+('S'<<8)+'J')	// little-endian "JSAV"
 #define SAVEGAME_VERSION		0x0065				// Version 0.65
 #define CLIENT_SAVEGAME_VERSION	0x0068				// Version 0.68
+#define SAVEFILE_VERSION		0x0066				// level file with packed entity table
+#define SAVEFILE_LZ_HEADER		(('Z'<<24)+('L'<<16)+('V'<<8)+'S')	// little-endian "SVLZ"
+#define SAVEFILE_LZ_VERSION		1
+#define ENTCLASS_HASH_SIZE		256
 
 #define SAVE_AGED_COUNT		2
 #define SAVENAME_LENGTH		128				// matches with MAX_OSPATH
 
+#define SAVE_COPY_SIZE		0x10000				// worker copy buffer
+
 #define LUMP_DECALS_OFFSET		0
 #define LUMP_STATIC_OFFSET		1
 #define LUMP_SOUNDS_OFFSET		2
@@ -102,6 +108,43 @@ typedef struct
 	float	time;
 } SAVE_LIGHTSTYLE;
 
+typedef struct
+{
+	char	name[SAVENAME_LENGTH];
+	file_t	*file;
+	int	size;
+} savelevel_t;
+
+// savegame that is being written by worker thread
+typedef struct
+{
+	HANDLE		hThread;
+	string		name;		// save/name.sav
+	string		tempname;		// replaces name when completely written
+	file_t		*file;
+	byte		*data;		// header, tokens and gamestate
+	int		datasize;
+	savelevel_t	*levels;		// save/*.HL? files to copy
+	int		numlevels;
+	int		written;
+	qboolean		failed;
+	double		snapshottime;	// main thread
+	double		writetime;	// worker thread
+} savejob_t;
+
+// compressed level file, followed by LZSS block
+typedef struct
+{
+	int		ident;
+	int		version;
+	int		rawsize;		// size of uncompressed file
+} savelzheader_t;
+
+static savejob_t	sv_savejob;
+static qboolean	sv_loadpacked;	// level file has packed entity table
+
+CVAR_DEFINE_AUTO( sv_save_compress, "1", FCVAR_ARCHIVE, "compress level files of savegames and level transitions" );
+
 static TYPEDESCRIPTION gGameHeader[] =
 {
 	DEFINE_ARRAY( GAME_HEADER, mapName, FIELD_CHARACTER, 32 ),
@@ -579,6 +622,9 @@ void SV_ClearSaveDir( void )
 	search_t	*t;
 	int	i;
 
+	// worker may read them right now
+	SV_FinishSaveGame( true );
+
 	// just delete all HL? files
 	t = FS_Search( "save/*.HL?", true, true );	// lookup only in gamedir
 	if( !t ) return; // already empty
@@ -697,32 +743,6 @@ void SV_AgeSaveList( const char *pName, int count )
 	}
 }
 
-void SV_DirectoryCopy( const char *pPath, file_t *pFile )
-{
-	search_t	*t;
-	file_t	*pCopy;
-	int	i, fileSize;
-	char	szName[SAVENAME_LENGTH];
-
-	t = FS_Search( pPath, true, true );
-	if( !t ) return;
-
-	for( i = 0; i < t->numfilenames; i++ )
-	{
-		fileSize = FS_FileSize( t->filenames[i], true );
-		pCopy = FS_Open( t->filenames[i], "rb", true );
-
-		// filename can only be as long as a map name + extension
-		Q_strncpy( szName, FS_FileWithoutPath( t->filenames[i] ), SAVENAME_LENGTH );		
-		FS_Write( pFile, szName, SAVENAME_LENGTH );
-		FS_Write( pFile, &fileSize, sizeof( int ));
-		FS_FileCopy( pFile, pCopy, fileSize );
-		FS_Close( pCopy );
-	}
-
-	Mem_Free( t );
-}
-
 void SV_DirectoryExtract( file_t *pFile, int fileCount )
 {
 	char	szName[SAVENAME_LENGTH];
@@ -743,6 +763,179 @@ void SV_DirectoryExtract( file_t *pFile, int fileCount )
 	}
 }
 
+/*
+=============
+SV_SaveThread
+
+write prepared savegame and copy
+all the level files into it
+=============
+*/
+static DWORD WINAPI SV_SaveThread( void *arg )
+{
+	static byte	buffer[SAVE_COPY_SIZE];
+	savejob_t		*job = (savejob_t *)arg;
+	double		start = Sys_DoubleTime();
+	savelevel_t	*level;
+	int		i, size, chunk;
+
+	job->written = FS_Write( job->file, job->data, job->datasize );
+	if( job->written != job->datasize ) job->failed = true;
+
+	for( i = 0, level = job->levels; i < job->numlevels && !job->failed; i++, level++ )
+	{
+		job->written += FS_Write( job->file, level->name, SAVENAME_LENGTH );
+		job->written += FS_Write( job->file, &level->size, sizeof( int ));
+
+		for( size = level->size; size > 0; size -= chunk )
+		{
+			chunk = FS_Read( level->file, buffer, Q_min( size, SAVE_COPY_SIZE ));
+
+			if( chunk <= 0 || FS_Write( job->file, buffer, chunk ) != chunk )
+			{
+				job->failed = true;
+				break;
+			}
+			job->written += chunk;
+		}
+	}
+
+	job->writetime = Sys_DoubleTime() - start;
+
+	return 0;
+}
+
+/*
+=============
+SV_StartSaveGame
+
+open level files and run the worker, snapshot
+of gamestate is copied so caller can free it
+=============
+*/
+static qboolean SV_StartSaveGame( const char *name, const char *pPath, SAVERESTOREDATA *pSaveData, const char *pTokenData, int tokenSize )
+{
+	savejob_t		*job = &sv_savejob;
+	int		i, size, *tags;
+	savelevel_t	*level;
+	search_t		*t;
+	DWORD		id;
+
+	Q_strncpy( job->name, name, sizeof( job->name ));
+	Q_snprintf( job->tempname, sizeof( job->tempname ), "%s.tmp", name );
+
+	job->file = FS_Open( job->tempname, "wb", true );
+
+	if( !job->file )
+	{
+		MsgDev( D_ERROR, "couldn't create %s\n", job->tempname );
+		memset( job, 0, sizeof( *job ));
+		return false;
+	}
+
+	// file header and token table is followed by gamestate
+	size = SaveRestore_GetCurPos( pSaveData );
+	job->datasize = sizeof( int ) * 5 + tokenSize + size;
+	job->data = Mem_Alloc( host.mempool, job->datasize );
+
+	tags = (int *)job->data;
+	tags[0] = SAVEGAME_HEADER;
+	tags[1] = SAVEGAME_VERSION;
+	tags[2] = size; // does not include token table
+	tags[3] = pSaveData->tokenCount;
+	tags[4] = tokenSize;
+	memcpy( job->data + sizeof( int ) * 5, pTokenData, tokenSize );
+	memcpy( job->data + sizeof( int ) * 5 + tokenSize, SaveRestore_GetBuffer( pSaveData ), size );
+
+	// level files are opened here because filesystem search isn't thread-safe
+	if(( t = FS_Search( pPath, true, true )) != NULL )
+	{
+		job->levels = Mem_Alloc( host.mempool, sizeof( savelevel_t ) * t->numfilenames );
+
+		for( i = 0; i < t->numfilenames; i++ )
+		{
+			level = &job->levels[job->numlevels];
+			level->file = FS_Open( t->filenames[i], "rb", true );
+			if( !level->file ) continue;
+
+			// filename can only be as long as a map name + extension
+			Q_strncpy( level->name, FS_FileWithoutPath( t->filenames[i] ), SAVENAME_LENGTH );
+			level->size = FS_FileLength( level->file );
+			job->numlevels++;
+		}
+
+		Mem_Free( t );
+	}
+
+	job->hThread = CreateThread( NULL, 0, SV_SaveThread, job, 0, &id );
+
+	// write it right now if thread can't be started
+	if( !job->hThread ) SV_SaveThread( job );
+
+	return true;
+}
+
+/*
+=============
+SV_FinishSaveGame
+
+release the finished save job and replace
+previous savegame with the new one
+=============
+*/
+void SV_FinishSaveGame( qboolean wait )
+{
+	savejob_t	*job = &sv_savejob;
+	string	backup;
+	int	i;
+
+	if( !job->file ) return;
+
+	if( job->hThread )
+	{
+		if( WaitForSingleObject( job->hThread, wait ? INFINITE : 0 ) != WAIT_OBJECT_0 )
+			return; // still writing
+
+		CloseHandle( job->hThread );
+	}
+
+	FS_Close( job->file );
+
+	for( i = 0; i < job->numlevels; i++ )
+		FS_Close( job->levels[i].file );
+
+	if( job->levels ) Mem_Free( job->levels );
+	Mem_Free( job->data );
+
+	if( !job->failed )
+	{
+		// previous save is kept intact until new one is in place
+		Q_snprintf( backup, sizeof( backup ), "%s.bak", job->name );
+		FS_Delete( backup );
+		FS_Rename( job->name, backup );
+
+		if( FS_Rename( job->tempname, job->name ))
+		{
+			FS_Delete( backup );
+			MsgDev( D_INFO, "%s written (%s), snapshot %.1f msec, write %.1f msec\n", job->name,
+			Q_memprint( job->written ), job->snapshottime * 1000.0, job->writetime * 1000.0 );
+		}
+		else
+		{
+			// put the previous save back, new one is left in the temp file
+			FS_Rename( backup, job->name );
+			MsgDev( D_ERROR, "couldn't rename %s to %s\n", job->tempname, job->name );
+		}
+	}
+	else
+	{
+		MsgDev( D_ERROR, "couldn't write %s\n", job->name );
+		FS_Delete( job->tempname );
+	}
+
+	memset( job, 0, sizeof( *job ));
+}
+
 void SV_SaveFinish( SAVERESTOREDATA *pSaveData )
 {
 	char 		**pTokens;
@@ -783,6 +976,266 @@ SAVERESTOREDATA *SV_SaveInit( int size )
 	return pSaveData;
 }
 
+/*
+=============
+SV_WriteLevelFile
+
+write level file, compressed if allowed
+=============
+*/
+static qboolean SV_WriteLevelFile( const char *name, const byte *data, int size )
+{
+	savelzheader_t	header;
+	byte		*packed = NULL;
+	int		packedsize = 0;
+	file_t		*pFile;
+
+	if( sv_save_compress.value )
+	{
+		packed = Mem_Alloc( host.mempool, size );
+		packedsize = LZSS_Compress( data, size, packed, size );
+	}
+
+	pFile = FS_Open( name, "wb", true );
+
+	if( !pFile )
+	{
+		if( packed ) Mem_Free( packed );
+		return false;
+	}
+
+	// incompressible data is stored as is
+	if( packedsize > 0 )
+	{
+		header.ident = SAVEFILE_LZ_HEADER;
+		header.version = SAVEFILE_LZ_VERSION;
+		header.rawsize = size;
+		FS_Write( pFile, &header, sizeof( header ));
+		FS_Write( pFile, packed, packedsize );
+	}
+	else FS_Write( pFile, data, size );
+
+	FS_Close( pFile );
+	if( packed ) Mem_Free( packed );
+
+	return true;
+}
+
+/*
+=============
+SV_LoadLevelFile
+
+returns uncompressed image of level file,
+old files without container are returned as is
+=============
+*/
+static byte *SV_LoadLevelFile( const char *name, int *rawsize, int *storedsize )
+{
+	savelzheader_t	header;
+	byte		*data, *raw;
+	long		size;
+
+	data = FS_LoadFile( name, &size, true );
+	if( !data ) return NULL;
+
+	if( storedsize ) *storedsize = size;
+
+	if( size >= sizeof( header ))
+		memcpy( &header, data, sizeof( header ));
+	else header.ident = 0;
+
+	if( header.ident != SAVEFILE_LZ_HEADER )
+	{
+		if( rawsize ) *rawsize = size;
+		return data;
+	}
+
+	if( header.version != SAVEFILE_LZ_VERSION || header.rawsize <= 0 )
+	{
+		MsgDev( D_ERROR, "%s has unknown compression version %i\n", name, header.version );
+		Mem_Free( data );
+		return NULL;
+	}
+
+	raw = Mem_Alloc( host.mempool, header.rawsize );
+
+	if( LZSS_Decompress( data + sizeof( header ), size - sizeof( header ), raw, header.rawsize ) != header.rawsize )
+	{
+		MsgDev( D_ERROR, "%s is corrupted\n", name );
+		Mem_Free( data );
+		Mem_Free( raw );
+		return NULL;
+	}
+
+	if( rawsize ) *rawsize = header.rawsize;
+	Mem_Free( data );
+
+	return raw;
+}
+
+static void SaveRestore_WriteVarInt( SAVERESTOREDATA *pSaveData, uint value )
+{
+	byte	buf[5];
+	int	len = 0;
+
+	while( value >= 0x80 )
+	{
+		buf[len++] = (byte)( value | 0x80 );
+		value >>= 7;
+	}
+
+	buf[len++] = (byte)value;
+	SaveRestore_Write( pSaveData, buf, len );
+}
+
+static uint SaveRestore_ReadVarInt( SAVERESTOREDATA *pSaveData )
+{
+	uint	value = 0;
+	int	shift;
+	byte	b;
+
+	for( shift = 0; shift < 35; shift += 7 )
+	{
+		if( !SaveRestore_Read( pSaveData, &b, 1 ))
+			break;
+
+		value |= (uint)( b & 0x7F ) << shift;
+		if( !( b & 0x80 )) break;
+	}
+
+	return value;
+}
+
+/*
+=============
+SV_WriteEntityTable
+
+entity table is written with variable length integers,
+each classname is stored once and referenced by index
+=============
+*/
+static void SV_WriteEntityTable( SAVERESTOREDATA *pSaveData )
+{
+	int		hashTable[ENTCLASS_HASH_SIZE];
+	int		*classIndex, *hashNext;
+	int		i, j, delta, lastPos = 0;
+	const char	**classNames;
+	const char	*pszName;
+	int		numClasses = 0;
+	ENTITYTABLE	*pTable;
+	uint		hash;
+
+	classIndex = Mem_Alloc( host.mempool, sizeof( int ) * pSaveData->tableCount );
+	hashNext = Mem_Alloc( host.mempool, sizeof( int ) * pSaveData->tableCount );
+	classNames = Mem_Alloc( host.mempool, sizeof( char* ) * pSaveData->tableCount );
+	memset( hashTable, 0xFF, sizeof( hashTable ));	// fill with -1
+
+	// collect unique classnames
+	for( i = 0; i < pSaveData->tableCount; i++ )
+	{
+		pTable = &pSaveData->pTable[i];
+		if( !pTable->classname ) continue;
+
+		pszName = STRING( pTable->classname );
+		hash = Com_HashKey( pszName, ENTCLASS_HASH_SIZE );
+
+		for( j = hashTable[hash]; j != -1; j = hashNext[j] )
+		{
+			if( !Q_strcmp( classNames[j], pszName ))
+				break;
+		}
+
+		if( j == -1 )
+		{
+			j = numClasses++;
+			classNames[j] = pszName;
+			hashNext[j] = hashTable[hash];
+			hashTable[hash] = j;
+		}
+
+		classIndex[i] = j + 1; // 0 is reserved for entities without classname
+	}
+
+	SaveRestore_WriteVarInt( pSaveData, numClasses );
+
+	for( j = 0; j < numClasses; j++ )
+		SaveRestore_Write( pSaveData, classNames[j], Q_strlen( classNames[j] ) + 1 );
+
+	for( i = 0; i < pSaveData->tableCount; i++ )
+	{
+		pTable = &pSaveData->pTable[i];
+
+		// entity data usually follows the previous one
+		delta = pTable->location - lastPos;
+
+		SaveRestore_WriteVarInt( pSaveData, pTable->id );
+		SaveRestore_WriteVarInt( pSaveData, ((uint)delta << 1 ) ^ (uint)( delta >> 31 ));
+		SaveRestore_WriteVarInt( pSaveData, pTable->size );
+		SaveRestore_WriteVarInt( pSaveData, pTable->flags );
+		SaveRestore_WriteVarInt( pSaveData, classIndex[i] );
+
+		lastPos = pTable->location + pTable->size;
+	}
+
+	Mem_Free( classNames );
+	Mem_Free( classIndex );
+	Mem_Free( hashNext );
+}
+
+/*
+=============
+SV_ReadPackedEntityTable
+=============
+*/
+static void SV_ReadPackedEntityTable( SAVERESTOREDATA *pSaveData )
+{
+	int		i, len, avail, lastPos = 0;
+	int		numClasses;
+	string_t		*classNames;
+	ENTITYTABLE	*pTable;
+	char		*pszName;
+	uint		value;
+
+	// each classname takes a byte at least
+	numClasses = SaveRestore_ReadVarInt( pSaveData );
+	numClasses = bound( 0, numClasses, SaveRestore_BytesAvailable( pSaveData ));
+	classNames = Mem_Alloc( host.mempool, sizeof( string_t ) * ( numClasses + 1 ));
+
+	for( i = 0; i < numClasses; i++ )
+	{
+		pszName = SaveRestore_AccessCurPos( pSaveData );
+		avail = SaveRestore_BytesAvailable( pSaveData );
+
+		for( len = 0; len < avail && pszName[len]; len++ );
+
+		if( len == avail )
+		{
+			MsgDev( D_ERROR, "SV_ReadEntityTable: bad classname table\n" );
+			break;
+		}
+
+		classNames[i + 1] = ALLOC_STRING( pszName );
+		SaveRestore_MoveCurPos( pSaveData, len + 1 );
+	}
+
+	for( i = 0; i < pSaveData->tableCount; i++ )
+	{
+		pTable = &pSaveData->pTable[i];
+
+		pTable->id = SaveRestore_ReadVarInt( pSaveData );
+		value = SaveRestore_ReadVarInt( pSaveData );
+		pTable->location = lastPos + (int)(( value >> 1 ) ^ ( 0 - ( value & 1 )));
+		pTable->size = SaveRestore_ReadVarInt( pSaveData );
+		pTable->flags = SaveRestore_ReadVarInt( pSaveData );
+		value = SaveRestore_ReadVarInt( pSaveData );
+		pTable->classname = ( value <= (uint)numClasses ) ? classNames[value] : 0;
+
+		lastPos = pTable->location + pTable->size;
+	}
+
+	Mem_Free( classNames );
+}
+
 void SV_SaveGameStateGlobals( SAVERESTOREDATA *pSaveData )
 {
 	sv_client_t	*cl;
@@ -839,8 +1292,7 @@ void SV_SaveGameStateGlobals( SAVERESTOREDATA *pSaveData )
 	pSaveData->time = header.time;
 
 	// write entity table
-	for( i = 0; i < pSaveData->tableCount; i++ )
-		svgame.dllFuncs.pfnSaveWriteFields( pSaveData, "ETABLE", pSaveData->pTable + i, gEntityTable, ARRAYSIZE( gEntityTable ));
+	SV_WriteEntityTable( pSaveData );
 
 	// write adjacency list
 	for( i = 0; i < pSaveData->connectionCount; i++ )
@@ -862,41 +1314,59 @@ void SV_SaveGameStateGlobals( SAVERESTOREDATA *pSaveData )
 SAVERESTOREDATA *SV_LoadSaveData( const char *level )
 {
 	string			name;
-	file_t			*pFile;
 	SaveFileSectionsInfo_t	sectionsInfo;
 	SAVERESTOREDATA		*pSaveData;
 	char			*pszTokenList;
 	int			i, id, size, version;
+	int			headerSize, fileSize;
+	byte			*pFile;
 	
 	Q_snprintf( name, sizeof( name ), "save/%s.HL1", level );
 	MsgDev( D_INFO, "Loading game from %s...\n", name );
 
-	pFile = FS_Open( name, "rb", true );
+	pFile = SV_LoadLevelFile( name, &fileSize, NULL );
 	if( !pFile )
 	{
 		MsgDev( D_INFO, "ERROR: couldn't open.\n" );
 		return NULL;
 	}
 
+	headerSize = sizeof( int ) * 2 + sizeof( sectionsInfo );
+
+	if( fileSize < headerSize )
+	{
+		Mem_Free( pFile );
+		return NULL;
+	}
+
 	// Read the header
-	FS_Read( pFile, &id, sizeof( int ));
-	FS_Read( pFile, &version, sizeof( int ));
+	memcpy( &id, pFile, sizeof( int ));
+	memcpy( &version, pFile + sizeof( int ), sizeof( int ));
 
 	// is this a valid save?
-	if( id != SAVEFILE_HEADER || version != SAVEGAME_VERSION )
+	if( id != SAVEFILE_HEADER || ( version != SAVEGAME_VERSION && version != SAVEFILE_VERSION ))
 	{
-		FS_Close( pFile );
+		Mem_Free( pFile );
 		return NULL;
 	}
 
 	// Read the sections info and the data
-	FS_Read( pFile, &sectionsInfo, sizeof( sectionsInfo ));
+	memcpy( &sectionsInfo, pFile + sizeof( int ) * 2, sizeof( sectionsInfo ));
+
+	if( SumBytes( &sectionsInfo ) > fileSize - headerSize )
+	{
+		Mem_Free( pFile );
+		return NULL;
+	}
+
+	// old level files has entity table written by game dll
+	sv_loadpacked = ( version == SAVEFILE_VERSION );
 
 	pSaveData = Mem_Alloc( host.mempool, sizeof(SAVERESTOREDATA) + SumBytes( &sectionsInfo ));
 	Q_strncpy( pSaveData->szCurrentMapName, level, sizeof( pSaveData->szCurrentMapName ));
 	
-	FS_Read( pFile, (char *)(pSaveData + 1), SumBytes( &sectionsInfo ));
-	FS_Close( pFile );
+	memcpy( (char *)(pSaveData + 1), pFile + headerSize, SumBytes( &sectionsInfo ));
+	Mem_Free( pFile );
 	
 	// Parse the symbol table
 	pszTokenList = (char *)(pSaveData + 1);	// Skip past the CSaveRestoreData structure
@@ -949,6 +1419,12 @@ void SV_ReadEntityTable( SAVERESTOREDATA *pSaveData )
 	pEntityTable = (ENTITYTABLE *)Mem_Alloc( host.mempool, sizeof( ENTITYTABLE ) * pSaveData->tableCount );
 	SaveRestore_InitEntityTable( pSaveData, pEntityTable, pSaveData->tableCount );
 
+	if( sv_loadpacked )
+	{
+		SV_ReadPackedEntityTable( pSaveData );
+		return;
+	}
+
 	for( i = 0; i < pSaveData->tableCount; i++ )
 		svgame.dllFuncs.pfnSaveReadFields( pSaveData, "ETABLE", pSaveData->pTable + i, gEntityTable, ARRAYSIZE( gEntityTable ));
 }
@@ -1438,9 +1914,12 @@ SAVERESTOREDATA *SV_SaveGameState( void )
 	SaveFileSections_t		sections;
 	SAVERESTOREDATA		*pSaveData;
 	ENTITYTABLE		*pTable;
-	file_t			*pFile;
-	int			i, numents;
+	int			i, numents, size;
 	int			id, version;
+	byte			*pFile;
+
+	// level files will be overwritten
+	SV_FinishSaveGame( true );
 
 	pSaveData = SV_SaveInit( 0 );
 
@@ -1497,23 +1976,35 @@ SAVERESTOREDATA *SV_SaveGameState( void )
 	sectionsInfo.nSymbols = pSaveData->tokenCount;
 
 	id = SAVEFILE_HEADER;
-	version = SAVEGAME_VERSION;
+	version = SAVEFILE_VERSION;
 
-	// output to disk
-	pFile = FS_Open( va( "save/%s.HL1", sv.name ), "wb", true );
-	if( !pFile ) return NULL;
+	// level file is built in memory to compress it at once
+	size = sizeof( int ) * 2 + sizeof( sectionsInfo ) + SumBytes( &sectionsInfo );
+	pFile = Mem_Alloc( host.mempool, size );
 
 	// write the header
-	FS_Write( pFile, &id, sizeof( int ));
-	FS_Write( pFile, &version, sizeof( int ));
+	memcpy( pFile, &id, sizeof( int ));
+	memcpy( pFile + sizeof( int ), &version, sizeof( int ));
+	memcpy( pFile + sizeof( int ) * 2, &sectionsInfo, sizeof( sectionsInfo ));
+	size = sizeof( int ) * 2 + sizeof( sectionsInfo );
 
 	// Write out the tokens and table FIRST so they are loaded in the right order,
 	// then write out the rest of the data in the file.
-	FS_Write( pFile, &sectionsInfo, sizeof( sectionsInfo ));
-	FS_Write( pFile, sections.pSymbols, sectionsInfo.nBytesSymbols );
-	FS_Write( pFile, sections.pDataHeaders, sectionsInfo.nBytesDataHeaders );
-	FS_Write( pFile, sections.pData, sectionsInfo.nBytesData );
-	FS_Close( pFile );
+	memcpy( pFile + size, sections.pSymbols, sectionsInfo.nBytesSymbols );
+	size += sectionsInfo.nBytesSymbols;
+	memcpy( pFile + size, sections.pDataHeaders, sectionsInfo.nBytesDataHeaders );
+	size += sectionsInfo.nBytesDataHeaders;
+	memcpy( pFile + size, sections.pData, sectionsInfo.nBytesData );
+	size += sectionsInfo.nBytesData;
+
+	// output to disk
+	if( !SV_WriteLevelFile( va( "save/%s.HL1", sv.name ), pFile, size ))
+	{
+		Mem_Free( pFile );
+		return NULL;
+	}
+
+	Mem_Free( pFile );
 
 	SV_EntityPatchWrite( pSaveData, sv.name );
 
@@ -1527,13 +2018,16 @@ int SV_LoadGameState( char const *level, qboolean createPlayers )
 	SAVE_HEADER	header;
 	SAVERESTOREDATA	*pSaveData;
 	ENTITYTABLE	*pEntInfo;
+	double		start, tabletime;
 	edict_t		*pent;
 	int		i;
 
 	pSaveData = SV_LoadSaveData( level );
 	if( !pSaveData ) return 0; // couldn't load the file
 
+	start = Sys_DoubleTime();
 	SV_ParseSaveTables( pSaveData, &header, true );
+	tabletime = Sys_DoubleTime() - start;
 
 	SV_EntityPatchRead( pSaveData, level );
 
@@ -1621,6 +2115,10 @@ int SV_LoadGameState( char const *level, qboolean createPlayers )
 	}
 
 	// now spawn entities
+	svgame.numFuncLookups = 0;
+	svgame.funcLookupTime = 0.0;
+	start = Sys_DoubleTime();
+
 	for( i = 0; i < pSaveData->tableCount; i++ )
 	{
 		pEntInfo = &pSaveData->pTable[i];
@@ -1638,6 +2136,10 @@ int SV_LoadGameState( char const *level, qboolean createPlayers )
 		}
 	}
 
+	// time spent in game dll reading fields and restoring entities
+	MsgDev( D_INFO, "%s restored (%i entities), tables %.1f msec, entities %.1f msec, %i function lookups %.1f msec\n", level,
+	pSaveData->tableCount, tabletime * 1000.0, ( Sys_DoubleTime() - start ) * 1000.0, svgame.numFuncLookups, svgame.funcLookupTime * 1000.0 );
+
 	// restore camera view here
 	pent = pSaveData->pTable[bound( 0, (word)header.viewentity, pSaveData->tableCount )].pent;
 
@@ -1972,8 +2474,8 @@ int SV_SaveGameSlot( const char *pSaveName, const char *pSaveComment )
 	char		*pTokenData;
 	SAVERESTOREDATA	*pSaveData;
 	GAME_HEADER	gameHeader;
-	int		i, tag, tokenSize;
-	file_t		*pFile;
+	double		start = Sys_DoubleTime();
+	int		i, tokenSize;
 
 	pSaveData = SV_SaveGameState();
 	if( !pSaveData ) return 0;
@@ -2016,27 +2518,15 @@ int SV_SaveGameSlot( const char *pSaveName, const char *pSaveComment )
 	if( !Q_stricmp( pSaveName, "quick" ) || !Q_stricmp( pSaveName, "autosave" ))
 		SV_AgeSaveList( pSaveName, SAVE_AGED_COUNT );
 
-	pFile = FS_Open( name, "wb", true );
-
-	tag = SAVEGAME_HEADER;
-	FS_Write( pFile, &tag, sizeof( int ));
-	tag = SAVEGAME_VERSION;
-	FS_Write( pFile, &tag, sizeof( int ));
-	tag = SaveRestore_GetCurPos( pSaveData );
-	FS_Write( pFile, &tag, sizeof( int )); // does not include token table
-
-	// write out the tokens first so we can load them before we load the entities
-	tag = pSaveData->tokenCount;
-	FS_Write( pFile, &tag, sizeof( int ));
-	FS_Write( pFile, &tokenSize, sizeof( int ));
-	FS_Write( pFile, pTokenData, tokenSize );
-
-	// save gamestate
-	FS_Write( pFile, SaveRestore_GetBuffer( pSaveData ), SaveRestore_GetCurPos( pSaveData ));
+	// file is written in background
+	if( !SV_StartSaveGame( name, hlPath, pSaveData, pTokenData, tokenSize ))
+	{
+		SV_SaveFinish( pSaveData );
+		return 0;
+	}
 
-	SV_DirectoryCopy( hlPath, pFile );
-	FS_Close( pFile );
 	SV_SaveFinish( pSaveData );
+	sv_savejob.snapshottime = Sys_DoubleTime() - start;
 
 	return 1;
 }
@@ -2122,6 +2612,9 @@ qboolean SV_LoadGame( const char *pPath )
 	if( !pPath || !pPath[0] )
 		return false;
 
+	// save which is still written exists only as .tmp file
+	SV_FinishSaveGame( true );
+
 	FS_FileBase( pPath, name );
 
 	// silently ignore if missed
@@ -2206,6 +2699,9 @@ void SV_SaveGame( const char *pName )
 	if( !SV_IsValidSave( ))
 		return;
 
+	// previous save must be renamed before looking for a free slot
+	SV_FinishSaveGame( true );
+
 	if( !Q_stricmp( pName, "new" ))
 	{
 		// scan for a free filename
@@ -2257,11 +2753,14 @@ used for reload game after player death
 */
 const char *SV_GetLatestSave( void )
 {
-	search_t	*f = FS_Search( "save/*.sav", true, true );	// lookup only in gamedir
+	search_t	*f;
 	int	i, found = 0;
 	long	newest = 0, ft;
 	string	savename;	
 
+	SV_FinishSaveGame( true );
+
+	f = FS_Search( "save/*.sav", true, true );	// lookup only in gamedir
 	if( !f ) return NULL;
 
 	for( i = 0; i < f->numfilenames; i++ )
@@ -2288,6 +2787,56 @@ const char *SV_GetLatestSave( void )
 	return NULL; 
 }
 
+/*
+=============
+SV_SaveInfo_f
+
+show raw and stored size of level files
+and how long they take to load
+=============
+*/
+void SV_SaveInfo_f( void )
+{
+	int	totalRaw = 0, totalStored = 0;
+	int	i, rawSize, storedSize;
+	double	start, loadTime, totalTime = 0.0;
+	search_t	*t;
+	byte	*data;
+
+	t = FS_Search( "save/*.HL?", true, true );	// lookup only in gamedir
+
+	if( !t )
+	{
+		Msg( "no level files in save directory\n" );
+		return;
+	}
+
+	Msg( "%-24s %10s %10s %6s %8s\n", "file", "raw", "stored", "ratio", "msec" );
+	Msg( "---------------------------------------------------------------\n" );
+
+	for( i = 0; i < t->numfilenames; i++ )
+	{
+		start = Sys_DoubleTime();
+		data = SV_LoadLevelFile( t->filenames[i], &rawSize, &storedSize );
+		loadTime = Sys_DoubleTime() - start;
+
+		if( !data ) continue;
+		Mem_Free( data );
+
+		Msg( "%-24s %10i %10i %5.1f%% %8.2f\n", FS_FileWithoutPath( t->filenames[i] ), rawSize, storedSize,
+			storedSize * 100.0f / Q_max( rawSize, 1 ), loadTime * 1000.0 );
+
+		totalRaw += rawSize;
+		totalStored += storedSize;
+		totalTime += loadTime;
+	}
+
+	Msg( "%i files, %s raw, %s stored, loaded in %.2f msec\n", t->numfilenames,
+		Q_memprint( totalRaw ), Q_memprint( totalStored ), totalTime * 1000.0 );
+
+	Mem_Free( t );
+}
+
 qboolean SV_GetComment( const char *savename, char *comment )
 {
 	int	i, tag, size, nNumberOfFields, nFieldSize, tokenSize, tokenCount;
@@ -2295,6 +2844,9 @@ qboolean SV_GetComment( const char *savename, char *comment )
 	string	name, description;
 	file_t	*f;
 
+	// don't read the previous file while the new one is written
+	SV_FinishSaveGame( true );
+
 	f = FS_Open( savename, "rb", true );
 	if( !f )
 	{
@@ -422,6 +422,7 @@ areanode_t *SV_CreateAreaNode( int depth, vec3_t mins, vec3_t maxs )
 
 	ClearLink( &anode->trigger_edicts );
 	ClearLink( &anode->solid_edicts );
+	ClearLink( &anode->nonsolid_edicts );
 	
 	if( depth == AREA_DEPTH )
 	{
@@ -559,7 +560,9 @@ void SV_TouchLinks( edict_t *ent, areanode_t *node )
 		if( !( sv.hostflags & SVF_PLAYERSONLY ))
 		{
 			svgame.globals->time = sv.time;
+			SV_BeginPhase( SVP_TOUCH );
 			svgame.dllFuncs.pfnTouch( touch, ent );
+			SV_EndPhase( SVP_TOUCH );
 		}
 	}
 	
@@ -629,6 +632,9 @@ void SV_LinkEdict( edict_t *ent, qboolean touch_triggers )
 	if( ent == svgame.edicts ) return;		// don't add the world
 	if( !SV_IsValidEdict( ent )) return;		// never add freed ents
 
+	// something has moved us
+	SV_WakeEdict( ent );
+
 	// set the abs box
 	svgame.dllFuncs.pfnSetAbsBox( ent );
 
@@ -656,10 +662,6 @@ void SV_LinkEdict( edict_t *ent, qboolean touch_triggers )
 		}
 	}
 
-	// ignore non-solid bodies
-	if( ent->v.solid == SOLID_NOT && ent->v.skin >= CONTENTS_EMPTY )
-		return;
-
 	// find the first node that the ent's box crosses
 	node = sv_areanodes;
 
@@ -672,6 +674,13 @@ void SV_LinkEdict( edict_t *ent, qboolean touch_triggers )
 			node = node->children[1];
 		else break; // crosses the node
 	}
+
+	// non-solid bodies are linked only to be found by SV_AreaEdicts
+	if( ent->v.solid == SOLID_NOT && ent->v.skin >= CONTENTS_EMPTY )
+	{
+		InsertLinkBefore( &ent->area, &node->nonsolid_edicts );
+		return;
+	}
 	
 	// link it in	
 	if( ent->v.solid == SOLID_TRIGGER )
@@ -689,6 +698,118 @@ void SV_LinkEdict( edict_t *ent, qboolean touch_triggers )
 /*
 ===============================================================================
 
+AREA QUERIES
+
+===============================================================================
+*/
+typedef struct
+{
+	const float	*mins;
+	const float	*maxs;
+	int		flagmask;
+	int		count;
+} areaquery_t;
+
+static edict_t	*sv_areaedicts[MAX_EDICTS];
+
+/*
+====================
+SV_AreaLinks
+====================
+*/
+static void SV_AreaLinks( link_t *head, areaquery_t *aq )
+{
+	link_t	*l;
+	edict_t	*touch;
+
+	for( l = head->next; l != head; l = l->next )
+	{
+		touch = EDICT_FROM_AREA( l );
+
+		if( aq->flagmask && !FBitSet( touch->v.flags, aq->flagmask ))
+			continue;
+
+		if( !BoundsIntersect( aq->mins, aq->maxs, touch->v.absmin, touch->v.absmax ))
+			continue;
+
+		if( aq->count == MAX_EDICTS )
+			return; // can't happen, each edict is linked only once
+
+		sv_areaedicts[aq->count++] = touch;
+	}
+}
+
+/*
+====================
+SV_AreaEdicts_r
+====================
+*/
+static void SV_AreaEdicts_r( areanode_t *node, areaquery_t *aq )
+{
+	SV_AreaLinks( &node->solid_edicts, aq );
+	SV_AreaLinks( &node->trigger_edicts, aq );
+	SV_AreaLinks( &node->nonsolid_edicts, aq );
+
+	// recurse down both sides
+	if( node->axis == -1 ) return;
+
+	if( aq->maxs[node->axis] > node->dist )
+		SV_AreaEdicts_r( node->children[0], aq );
+	if( aq->mins[node->axis] < node->dist )
+		SV_AreaEdicts_r( node->children[1], aq );
+}
+
+/*
+====================
+SV_CompareEdicts
+====================
+*/
+static int SV_CompareEdicts( const void *a, const void *b )
+{
+	const edict_t	*ea = *(const edict_t **)a;
+	const edict_t	*eb = *(const edict_t **)b;
+
+	if( ea < eb ) return -1;
+	if( ea > eb ) return 1;
+	return 0;
+}
+
+/*
+====================
+SV_AreaEdicts
+
+fills list with linked entities that touch the box
+and has any of flagmask bits. Result is sorted by entity
+index, so the same entities as with linear scan over all
+edicts are returned when list is not big enough
+====================
+*/
+int SV_AreaEdicts( const vec3_t mins, const vec3_t maxs, edict_t **list, int maxcount, int flagmask )
+{
+	areaquery_t	aq;
+
+	if( !list || maxcount <= 0 || !sv_numareanodes )
+		return 0;
+
+	aq.mins = mins;
+	aq.maxs = maxs;
+	aq.flagmask = flagmask;
+	aq.count = 0;
+
+	SV_AreaEdicts_r( sv_areanodes, &aq );
+
+	if( aq.count > 1 )
+		qsort( sv_areaedicts, aq.count, sizeof( edict_t* ), SV_CompareEdicts );
+
+	aq.count = Q_min( aq.count, maxcount );
+	memcpy( list, sv_areaedicts, aq.count * sizeof( edict_t* ));
+
+	return aq.count;
+}
+
+/*
+===============================================================================
+
 POINT TESTING IN HULLS
 
 ===============================================================================
@@ -1158,19 +1279,72 @@ void SV_ClipToWorldBrush( areanode_t *node, moveclip_t *clip )
 		SV_ClipToWorldBrush( node->children[1], clip );
 }
 
+/*
+==================
+SV_AreaHasSolids
+
+returns true if any solid entity except
+passedict is linked into the box
+==================
+*/
+qboolean SV_AreaHasSolids( areanode_t *node, const vec3_t mins, const vec3_t maxs, edict_t *passedict )
+{
+	link_t	*l;
+	edict_t	*touch;
+
+	for( l = node->solid_edicts.next; l != &node->solid_edicts; l = l->next )
+	{
+		touch = EDICT_FROM_AREA( l );
+
+		if( touch == passedict )
+			continue;
+
+		if( BoundsIntersect( mins, maxs, touch->v.absmin, touch->v.absmax ))
+			return true;
+	}
+
+	// recurse down both sides
+	if( node->axis == -1 ) return false;
+
+	if( maxs[node->axis] > node->dist && SV_AreaHasSolids( node->children[0], mins, maxs, passedict ))
+		return true;
+	if( mins[node->axis] < node->dist && SV_AreaHasSolids( node->children[1], mins, maxs, passedict ))
+		return true;
+
+	return false;
+}
+
 /*
 ==================
 SV_Move
 ==================
 */
 trace_t SV_Move( const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int type, edict_t *e, qboolean monsterclip )
+{
+	trace_t	trace;
+
+	SV_ClipMoveToEntity( EDICT_NUM( 0 ), start, mins, maxs, end, &trace );
+
+	return SV_MoveFromWorldTrace( &trace, start, mins, maxs, type, e, monsterclip );
+}
+
+/*
+==================
+SV_MoveFromWorldTrace
+
+second half of SV_Move: clip the move against entities
+when the trace against world is already done
+(may be computed by another thread)
+==================
+*/
+trace_t SV_MoveFromWorldTrace( const trace_t *worldtrace, const vec3_t start, vec3_t mins, vec3_t maxs, int type, edict_t *e, qboolean monsterclip )
 {
 	moveclip_t	clip;
 	vec3_t		trace_endpos;
 	float		trace_fraction;
 
 	memset( &clip, 0, sizeof( moveclip_t ));
-	SV_ClipMoveToEntity( EDICT_NUM( 0 ), start, mins, maxs, end, &clip.trace );
+	clip.trace = *worldtrace;
 
 	if( clip.trace.fraction != 0.0f )
 	{